@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <print>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+/**
+ * Submit a job to the server started by <tt>mipmap --serve=<socket-path></tt>, and print its response.
+ *
+ * Job arguments are the same as the one-shot execution. Paths are made absolute as the server may have a different
+ * working directory.
+ */
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::println(std::cerr, "Usage: {} <socket-path> [<mipmap-options>...] <image-path | shm:<name>> <output-dir>", argv[0]);
+        std::exit(1);
+    }
+
+    // Each argument is terminated by a null character.
+    std::string request;
+    for (std::string_view arg : std::span { argv + 2, argv + argc }) {
+        if (arg.starts_with("--") || arg.starts_with("shm:")) {
+            request += arg;
+        }
+        else {
+            request += std::filesystem::absolute(arg).string();
+        }
+        request += '\0';
+    }
+
+    try {
+        sockaddr_un address { .sun_family = AF_UNIX };
+        const std::string_view socketPath = argv[1];
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error { std::format("Socket path is too long: {}", socketPath) };
+        }
+        std::ranges::copy(socketPath, address.sun_path);
+
+        const int connection = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (connection == -1) {
+            throw std::system_error { errno, std::generic_category(), "Failed to create socket" };
+        }
+        if (connect(connection, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1) {
+            const int error = errno;
+            close(connection);
+            throw std::system_error { error, std::generic_category(), std::format("Failed to connect to {}", socketPath) };
+        }
+
+        // Send the job, and notify its end by shutting down the writing side.
+        for (std::string_view remaining = request; !remaining.empty();) {
+            const ssize_t writtenSize = write(connection, remaining.data(), remaining.size());
+            if (writtenSize == -1) {
+                const int error = errno;
+                close(connection);
+                throw std::system_error { error, std::generic_category(), "Failed to send job" };
+            }
+            remaining.remove_prefix(writtenSize);
+        }
+        shutdown(connection, SHUT_WR);
+
+        // Response is sent after the job is done.
+        std::string response;
+        std::array<char, 4096> chunk;
+        for (ssize_t readSize; (readSize = read(connection, chunk.data(), chunk.size())) > 0;) {
+            response.append(chunk.data(), readSize);
+        }
+        close(connection);
+
+        std::print("{}", response);
+        return response.starts_with("ok") ? 0 : 1;
+    }
+    catch (const std::exception &e) {
+        std::println(std::cerr, "{}", e.what());
+        return 1;
+    }
+}
\ No newline at end of file
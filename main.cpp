@@ -1,6 +1,34 @@
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <future>
 #include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <mutex>
+#include <optional>
 #include <print>
 #include <set>
+#include <span>
+#include <system_error>
+#include <thread>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define MIPMAP_SERVER_SUPPORTED
+#define MIPMAP_MMAP_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
 
 #include <ImageData.hpp>
 #include <ranges.hpp>
@@ -15,378 +43,2050 @@
 #include <vulkan/vulkan_format_traits.hpp>
 
 #include "pipelines/MipmapComputer.hpp"
+#include "pipelines/SubgroupHiZComputer.hpp"
 #include "pipelines/SubgroupMipmapComputer.hpp"
+#include "pipelines/SubgroupVolumeMipmapComputer.hpp"
+#include "pipelines/VolumeMipmapComputer.hpp"
+
+#define FWD(...) static_cast<decltype(__VA_ARGS__) &&>(__VA_ARGS__)
+
+struct QueueFamilyIndices {
+    std::uint32_t computeGraphics;
+
+    explicit QueueFamilyIndices(
+        vk::PhysicalDevice physicalDevice
+    ) {
+        for (auto [queueFamilyIndex, properties] : physicalDevice.getQueueFamilyProperties() | ranges::views::enumerate) {
+            if (properties.queueFlags & vk::QueueFlagBits::eCompute && properties.queueFlags & vk::QueueFlagBits::eGraphics) {
+                computeGraphics = queueFamilyIndex;
+                return;
+            }
+        }
+
+        throw std::runtime_error { "Physical device doesn't have compute-graphics queue family" };
+    }
+};
+
+struct Queues {
+    vk::Queue computeGraphics;
+
+    Queues(
+        vk::Device device,
+        const QueueFamilyIndices &queueFamilyIndices
+    ) : computeGraphics { device.getQueue(queueFamilyIndices.computeGraphics, 0) } { }
+
+    [[nodiscard]] static auto getDeviceQueueCreateInfos(
+        const QueueFamilyIndices &queueFamilyIndices
+    ) -> std::array<vk::DeviceQueueCreateInfo, 1> {
+        static constexpr std::array queuePriorities { 1.f };
+        return std::array {
+            vk::DeviceQueueCreateInfo { {}, queueFamilyIndices.computeGraphics, queuePriorities },
+        };
+    }
+};
+
+enum class Strategy : std::uint8_t {
+    Blit,
+    ComputePerLevelBarriers,
+    ComputeSubgroup,
+    ComputeSubgroupFp16,
+    ComputeSubgroupClustered,
+    ComputeSubgroupQuad,
+};
+
+constexpr std::array allStrategies {
+    Strategy::Blit,
+    Strategy::ComputePerLevelBarriers,
+    Strategy::ComputeSubgroup,
+    Strategy::ComputeSubgroupFp16,
+    Strategy::ComputeSubgroupClustered,
+    Strategy::ComputeSubgroupQuad,
+};
+
+/**
+ * Get the name of \p strategy, which is used for both command line option and output filename.
+ */
+[[nodiscard]] constexpr auto getName(Strategy strategy) noexcept -> std::string_view {
+    switch (strategy) {
+        case Strategy::Blit: return "blit";
+        case Strategy::ComputePerLevelBarriers: return "compute_per_level_barriers";
+        case Strategy::ComputeSubgroup: return "compute_subgroup";
+        case Strategy::ComputeSubgroupFp16: return "compute_subgroup_fp16";
+        case Strategy::ComputeSubgroupClustered: return "compute_subgroup_clustered";
+        case Strategy::ComputeSubgroupQuad: return "compute_subgroup_quad";
+    }
+    std::unreachable();
+}
+
+[[nodiscard]] constexpr auto getLabel(Strategy strategy) noexcept -> std::string_view {
+    switch (strategy) {
+        case Strategy::Blit: return "Blit based mipmap generation";
+        case Strategy::ComputePerLevelBarriers: return "Compute shader mipmap generation with per-level barriers";
+        case Strategy::ComputeSubgroup: return "Compute shader mipmap generation with subgroup operation";
+        case Strategy::ComputeSubgroupFp16: return "Compute shader mipmap generation with fp16 subgroup operation";
+        case Strategy::ComputeSubgroupClustered: return "Compute shader mipmap generation with subgroup clustered operation";
+        case Strategy::ComputeSubgroupQuad: return "Compute shader mipmap generation with subgroup quad operation";
+    }
+    std::unreachable();
+}
+
+[[nodiscard]] constexpr auto getImageUsage(Strategy strategy) noexcept -> vk::ImageUsageFlags {
+    switch (strategy) {
+        case Strategy::Blit: return vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst;
+        case Strategy::ComputePerLevelBarriers:
+        case Strategy::ComputeSubgroup: case Strategy::ComputeSubgroupFp16:
+        case Strategy::ComputeSubgroupClustered: case Strategy::ComputeSubgroupQuad:
+            return vk::ImageUsageFlagBits::eStorage;
+    }
+    std::unreachable();
+}
+
+// Pipeline stage and access that an image is last written with.
+struct WriteScope {
+    vk::PipelineStageFlags2 stageMask;
+    vk::AccessFlags2 accessMask;
+};
+
+/**
+ * Get the pipeline stage and access that \p strategy writes the mip levels with.
+ */
+[[nodiscard]] constexpr auto getWriteScope(Strategy strategy) noexcept -> WriteScope {
+    switch (strategy) {
+        case Strategy::Blit: return { vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite };
+        case Strategy::ComputePerLevelBarriers:
+        case Strategy::ComputeSubgroup: case Strategy::ComputeSubgroupFp16:
+        case Strategy::ComputeSubgroupClustered: case Strategy::ComputeSubgroupQuad:
+            return { vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite };
+    }
+    std::unreachable();
+}
+
+/**
+ * Get the kernel used by the subgroup \p strategy for 2D images.
+ */
+[[nodiscard]] constexpr auto getSubgroupMipmapVariant(Strategy strategy) noexcept -> SubgroupMipmapComputer::Variant {
+    switch (strategy) {
+        case Strategy::ComputeSubgroupFp16: return SubgroupMipmapComputer::Variant::ShuffleFp16;
+        case Strategy::ComputeSubgroupClustered: return SubgroupMipmapComputer::Variant::Clustered;
+        case Strategy::ComputeSubgroupQuad: return SubgroupMipmapComputer::Variant::Quad;
+        default: return SubgroupMipmapComputer::Variant::Shuffle;
+    }
+}
+
+constexpr std::array allReductionModes { SubgroupHiZComputer::ReductionMode::Min, SubgroupHiZComputer::ReductionMode::Max, SubgroupHiZComputer::ReductionMode::MinMax };
+
+/**
+ * Get the name of Hi-Z \p reductionMode, which is used for both command line option and output filename.
+ */
+[[nodiscard]] constexpr auto getName(SubgroupHiZComputer::ReductionMode reductionMode) noexcept -> std::string_view {
+    switch (reductionMode) {
+        case SubgroupHiZComputer::ReductionMode::Min: return "min";
+        case SubgroupHiZComputer::ReductionMode::Max: return "max";
+        case SubgroupHiZComputer::ReductionMode::MinMax: return "minmax";
+    }
+    std::unreachable();
+}
+
+struct MipLevelRange {
+    std::uint32_t baseMipLevel;
+    std::uint32_t levelCount; // Can be vk::RemainingMipLevels.
+};
+
+struct Options {
+    std::filesystem::path imagePath;
+    std::filesystem::path outputDir;
+    std::vector<Strategy> strategies { allStrategies.begin(), allStrategies.end() };
+    // If true, strategies are executed one after another over a single image and destaging buffer. Otherwise, it is
+    // determined by the device memory budget.
+    bool budgeted = false;
+    // If specified, only these mip levels are read back, tightly packed in the destaging buffer, and written as
+    // separate files. Otherwise, all mip levels are read back into a single atlas.
+    std::optional<MipLevelRange> readbackMipLevels;
+    // If specified, after the full generation, the texels in this rect of the base level are modified (inverted) and
+    // only its footprint is regenerated.
+    std::optional<vk::Rect2D> dirtyRect;
+    // If true, the input image is treated as a vertical stack of the depth slices of a cubic 3D image, i.e. its height
+    // is the square of its width.
+    bool volume = false;
+    // If not empty, these images are packed into the layers of array images (one per distinct extent) and mipmapped by
+    // a single subgroup dispatch chain per array image, instead of imagePath. Strategies are ignored.
+    std::vector<std::filesystem::path> packedImagePaths;
+    // If specified, the input image is treated as a single channel depth image, and its Hi-Z pyramid is generated with
+    // this reduction mode instead of the color mipmaps. Strategies are ignored.
+    std::optional<SubgroupHiZComputer::ReductionMode> hizReductionMode;
+    // Number of threads that record the strategies in parallel. Ignored in budgeted execution.
+    std::uint32_t recordingThreadCount = 1;
+    // If specified, the device is initialized once and the jobs are received over the Unix domain socket at this path.
+    // Other options and arguments are given by each job.
+    std::optional<std::filesystem::path> serveSocketPath;
+
+    /**
+     * Parse command line arguments into options.
+     * @throw std::invalid_argument If arguments are ill-formed.
+     */
+    [[nodiscard]] static auto parse(std::span<const char* const> args) -> Options {
+        Options options;
+        std::vector<std::string_view> positionalArgs;
+        bool packed = false;
+        for (std::string_view arg : args) {
+            if (arg == "--budgeted") {
+                options.budgeted = true;
+            }
+            else if (arg == "--volume") {
+                options.volume = true;
+            }
+            else if (arg == "--packed") {
+                packed = true;
+            }
+            else if (arg.starts_with("--strategies=")) {
+                options.strategies.clear();
+                for (auto &&name : arg.substr(std::string_view { "--strategies=" }.size()) | std::views::split(',')) {
+                    const auto it = std::ranges::find(allStrategies, std::string_view { name }, [](Strategy strategy) { return getName(strategy); });
+                    if (it == allStrategies.end()) {
+                        throw std::invalid_argument { std::format("Unknown strategy: {}", std::string_view { name }) };
+                    }
+                    if (std::ranges::find(options.strategies, *it) == options.strategies.end()) {
+                        options.strategies.push_back(*it);
+                    }
+                }
+            }
+            else if (arg.starts_with("--levels=")) {
+                // <base>, <base>.. or <base>..<last> (inclusive).
+                const std::string_view range = arg.substr(std::string_view { "--levels=" }.size());
+                const std::size_t delimiterPos = range.find("..");
+                const std::uint32_t baseMipLevel = parseUnsigned(range.substr(0, delimiterPos));
+                if (delimiterPos == std::string_view::npos) {
+                    options.readbackMipLevels = MipLevelRange { baseMipLevel, 1U };
+                }
+                else if (const std::string_view last = range.substr(delimiterPos + 2); last.empty()) {
+                    options.readbackMipLevels = MipLevelRange { baseMipLevel, vk::RemainingMipLevels };
+                }
+                else if (const std::uint32_t lastMipLevel = parseUnsigned(last); lastMipLevel >= baseMipLevel) {
+                    options.readbackMipLevels = MipLevelRange { baseMipLevel, lastMipLevel - baseMipLevel + 1U };
+                }
+                else {
+                    throw std::invalid_argument { std::format("Invalid mip level range: {}", range) };
+                }
+            }
+            else if (arg.starts_with("--dirty-rect=")) {
+                // <x>,<y>,<width>,<height>
+                std::vector<std::uint32_t> values;
+                for (auto &&value : arg.substr(std::string_view { "--dirty-rect=" }.size()) | std::views::split(',')) {
+                    values.push_back(parseUnsigned(std::string_view { value }));
+                }
+                // Offsets must be representable by vk::Offset2D.
+                if (values.size() != 4 || values[0] > std::numeric_limits<std::int32_t>::max() || values[1] > std::numeric_limits<std::int32_t>::max()
+                    || values[2] == 0U || values[3] == 0U) {
+                    throw std::invalid_argument { std::format("Invalid dirty rect: {}", arg) };
+                }
+                options.dirtyRect.emplace(
+                    vk::Offset2D { static_cast<std::int32_t>(values[0]), static_cast<std::int32_t>(values[1]) },
+                    vk::Extent2D { values[2], values[3] });
+            }
+            else if (arg.starts_with("--threads=")) {
+                options.recordingThreadCount = parseUnsigned(arg.substr(std::string_view { "--threads=" }.size()));
+                if (options.recordingThreadCount == 0U) {
+                    throw std::invalid_argument { "Thread count must be at least 1" };
+                }
+            }
+            else if (arg.starts_with("--serve=")) {
+                options.serveSocketPath = arg.substr(std::string_view { "--serve=" }.size());
+            }
+            else if (arg.starts_with("--hiz=")) {
+                const std::string_view name = arg.substr(std::string_view { "--hiz=" }.size());
+                const auto it = std::ranges::find(allReductionModes, name, [](SubgroupHiZComputer::ReductionMode reductionMode) { return getName(reductionMode); });
+                if (it == allReductionModes.end()) {
+                    throw std::invalid_argument { std::format("Unknown Hi-Z reduction mode: {}", name) };
+                }
+                options.hizReductionMode = *it;
+            }
+            else if (arg.starts_with("--")) {
+                throw std::invalid_argument { std::format("Unknown option: {}", arg) };
+            }
+            else {
+                positionalArgs.push_back(arg);
+            }
+        }
+
+        if (options.serveSocketPath) {
+            if (!positionalArgs.empty()) {
+                throw std::invalid_argument { "Image path and output directory must be given by each job in server mode" };
+            }
+            return options;
+        }
+        if (packed) {
+            // <image-path>... <output-dir>
+            if (positionalArgs.size() < 2) {
+                throw std::invalid_argument { "At least one image path and output directory must be specified" };
+            }
+            if (options.volume || options.dirtyRect || options.hizReductionMode) {
+                throw std::invalid_argument { "Packed mode cannot be combined with volume, dirty rect or Hi-Z" };
+            }
+            options.packedImagePaths.assign(positionalArgs.begin(), positionalArgs.end() - 1);
+            options.outputDir = positionalArgs.back();
+            return options;
+        }
+        if (positionalArgs.size() != 2) {
+            throw std::invalid_argument { "Image path and output directory must be specified" };
+        }
+        if (options.strategies.empty()) {
+            throw std::invalid_argument { "At least one strategy must be specified" };
+        }
+        if (options.volume && options.dirtyRect) {
+            throw std::invalid_argument { "Dirty rect is not supported for volume" };
+        }
+        if (options.hizReductionMode && (options.volume || options.dirtyRect || options.readbackMipLevels)) {
+            throw std::invalid_argument { "Hi-Z cannot be combined with volume, dirty rect or readback mip levels" };
+        }
+        options.imagePath = positionalArgs[0];
+        options.outputDir = positionalArgs[1];
+        return options;
+    }
+
+private:
+    [[nodiscard]] static auto parseUnsigned(std::string_view str) -> std::uint32_t {
+        std::uint32_t value;
+        if (auto [ptr, ec] = std::from_chars(str.data(), str.data() + str.size(), value); ec != std::errc{} || ptr != str.data() + str.size()) {
+            throw std::invalid_argument { std::format("Invalid number: {}", str) };
+        }
+        return value;
+    }
+};
+
+/**
+ * Read-only view of the whole file at \p path, or of the POSIX shared memory object <tt><name></tt> if \p path is
+ * <tt>shm:<name></tt> (server mode only). The file is memory mapped if possible, otherwise read at once.
+ */
+class MappedFile {
+public:
+    explicit MappedFile(
+        const std::filesystem::path &path
+    ) {
+#ifdef MIPMAP_MMAP_SUPPORTED
+        const std::string pathString = path.string();
+        const bool isSharedMemory = pathString.starts_with("shm:");
+        const int fd = isSharedMemory
+            ? shm_open(pathString.substr(std::string_view { "shm:" }.size()).c_str(), O_RDONLY, 0)
+            : open(pathString.c_str(), O_RDONLY);
+        if (fd == -1) {
+            throw std::system_error { errno, std::generic_category(), std::format("Failed to open {}", pathString) };
+        }
+
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == -1) {
+            const int error = errno;
+            close(fd);
+            throw std::system_error { error, std::generic_category(), std::format("Failed to get the size of {}", pathString) };
+        }
+        if (fileStat.st_size == 0) {
+            close(fd);
+            throw std::runtime_error { std::format("Empty file: {}", pathString) };
+        }
+
+        size = static_cast<std::size_t>(fileStat.st_size);
+        mapped = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        const int error = errno;
+        close(fd);
+        if (mapped == MAP_FAILED) {
+            throw std::system_error { error, std::generic_category(), std::format("Failed to map {}", pathString) };
+        }
+
+        // Texels are read once from the beginning to the end.
+        madvise(mapped, size, MADV_SEQUENTIAL);
+#else
+        std::ifstream file { path, std::ios::binary | std::ios::ate };
+        if (!file) {
+            throw std::runtime_error { std::format("Failed to open {}", path.string()) };
+        }
+        contents.resize(static_cast<std::size_t>(file.tellg()));
+        file.seekg(0);
+        if (!file.read(reinterpret_cast<char*>(contents.data()), contents.size())) {
+            throw std::runtime_error { std::format("Failed to read {}", path.string()) };
+        }
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile(
+        MappedFile &&src
+    ) noexcept
+#ifdef MIPMAP_MMAP_SUPPORTED
+        : mapped { std::exchange(src.mapped, MAP_FAILED) },
+          size { std::exchange(src.size, 0) } { }
+#else
+        = default;
+#endif
+
+    auto operator=(const MappedFile&) -> MappedFile& = delete;
+    auto operator=(MappedFile&&) -> MappedFile& = delete;
+
+    ~MappedFile() {
+#ifdef MIPMAP_MMAP_SUPPORTED
+        if (mapped != MAP_FAILED) {
+            munmap(mapped, size);
+        }
+#endif
+    }
+
+    [[nodiscard]] auto getSpan() const noexcept -> std::span<const std::byte> {
+#ifdef MIPMAP_MMAP_SUPPORTED
+        return { static_cast<const std::byte*>(mapped), size };
+#else
+        return contents;
+#endif
+    }
+
+private:
+#ifdef MIPMAP_MMAP_SUPPORTED
+    void *mapped = MAP_FAILED;
+    std::size_t size = 0;
+#else
+    std::vector<std::byte> contents;
+#endif
+};
+
+/**
+ * RGBA8 texels of the input image at \p path.
+ *
+ * Encoded images (PNG, JPEG, ...) are decoded by stb_image. Already decoded images, i.e. raw RGBA dumps (RawHeader
+ * followed by tightly packed texels) and uncompressed <tt>VK_FORMAT_R8G8B8A8_UNORM</tt>/<tt>SRGB</tt> KTX2 files
+ * (level 0 is used), are not decoded: their texels are read from the memory mapping, therefore copying them into the
+ * staging buffer is the only copy.
+ */
+class InputImage {
+public:
+    // Header of raw RGBA dump. Fields are little-endian.
+    struct RawHeader {
+        std::array<char, 8> magic; // "RGBA8RAW"
+        std::uint32_t width;
+        std::uint32_t height;
+    };
+
+    int width, height;
+
+    explicit InputImage(
+        const std::filesystem::path &path
+    ) : file { path } {
+        const std::span bytes = file.getSpan();
+        if (!parseRaw(bytes) && !parseKtx2(bytes)) {
+            decoded.emplace(bytes, 4);
+            width = decoded->width;
+            height = decoded->height;
+            texels = decoded->getSpan();
+        }
+    }
+
+    [[nodiscard]] auto getSpan() const noexcept -> std::span<const std::uint8_t> {
+        return texels;
+    }
+
+private:
+    MappedFile file;
+    std::optional<ImageData<std::uint8_t>> decoded;
+    std::span<const std::uint8_t> texels;
+
+    /**
+     * Read the header of raw RGBA dump and set the extent and texels.
+     * @return <tt>false</tt> if \p bytes is not a raw RGBA dump.
+     */
+    auto parseRaw(
+        std::span<const std::byte> bytes
+    ) -> bool {
+        RawHeader header;
+        if (bytes.size() < sizeof(header)) {
+            return false;
+        }
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        if (std::string_view { header.magic.data(), header.magic.size() } != "RGBA8RAW") {
+            return false;
+        }
+
+        setTexels(bytes, header.width, header.height, sizeof(header));
+        return true;
+    }
+
+    /**
+     * Read the header and level index of KTX2 file and set the extent and texels of level 0.
+     * @return <tt>false</tt> if \p bytes is not a KTX2 file.
+     */
+    auto parseKtx2(
+        std::span<const std::byte> bytes
+    ) -> bool {
+        constexpr std::array<unsigned char, 12> identifier { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+        struct Header {
+            std::uint32_t vkFormat;
+            std::uint32_t typeSize;
+            std::uint32_t pixelWidth;
+            std::uint32_t pixelHeight;
+            std::uint32_t pixelDepth;
+            std::uint32_t layerCount;
+            std::uint32_t faceCount;
+            std::uint32_t levelCount;
+            std::uint32_t supercompressionScheme;
+        };
+        struct LevelIndex {
+            std::uint64_t byteOffset;
+            std::uint64_t byteLength;
+            std::uint64_t uncompressedByteLength;
+        };
+        // Level index follows the identifier, header, and the offsets/lengths of data format descriptor, key/value data
+        // and supercompression global data.
+        constexpr std::size_t levelIndexOffset = sizeof(identifier) + sizeof(Header) + 4 * sizeof(std::uint32_t) + 2 * sizeof(std::uint64_t);
+
+        if (bytes.size() < levelIndexOffset + sizeof(LevelIndex)
+            || std::memcmp(bytes.data(), identifier.data(), identifier.size()) != 0) {
+            return false;
+        }
+
+        Header header;
+        std::memcpy(&header, bytes.data() + sizeof(identifier), sizeof(header));
+        if (header.vkFormat != static_cast<std::uint32_t>(vk::Format::eR8G8B8A8Unorm)
+            && header.vkFormat != static_cast<std::uint32_t>(vk::Format::eR8G8B8A8Srgb)) {
+            throw std::runtime_error { std::format("KTX2 format must be R8G8B8A8_UNORM or R8G8B8A8_SRGB: {}", to_string(static_cast<vk::Format>(header.vkFormat))) };
+        }
+        if (header.pixelDepth != 0 || header.layerCount > 1 || header.faceCount != 1) {
+            throw std::runtime_error { "KTX2 image must be a single 2D image" };
+        }
+        if (header.supercompressionScheme != 0) {
+            throw std::runtime_error { "KTX2 image must not be supercompressed" };
+        }
+
+        LevelIndex level0;
+        std::memcpy(&level0, bytes.data() + levelIndexOffset, sizeof(level0));
+        if (level0.byteLength != 4ULL * header.pixelWidth * header.pixelHeight) {
+            throw std::runtime_error { "KTX2 level 0 size mismatch" };
+        }
+
+        setTexels(bytes, header.pixelWidth, header.pixelHeight, level0.byteOffset);
+        return true;
+    }
+
+    auto setTexels(
+        std::span<const std::byte> bytes,
+        std::uint32_t texelWidth,
+        std::uint32_t texelHeight,
+        std::uint64_t offset
+    ) -> void {
+        const std::uint64_t size = 4ULL * texelWidth * texelHeight;
+        if (texelWidth == 0 || texelHeight == 0 || texelWidth > std::numeric_limits<int>::max() || texelHeight > std::numeric_limits<int>::max()) {
+            throw std::runtime_error { std::format("Invalid image extent: {}x{}", texelWidth, texelHeight) };
+        }
+        if (offset > bytes.size() || size > bytes.size() - offset) {
+            throw std::runtime_error { "Image data is truncated" };
+        }
+
+        width = static_cast<int>(texelWidth);
+        height = static_cast<int>(texelHeight);
+        texels = { reinterpret_cast<const std::uint8_t*>(bytes.data() + offset), static_cast<std::size_t>(size) };
+    }
+};
+
+/**
+ * Images and persistently mapped buffers that are reused across jobs. Buffers are bucketed by power-of-two size, and
+ * images are matched by their creation info.
+ *
+ * Acquired resources can be acquired again after release(), which also destroys the least recently used ones if the
+ * pool exceeds the given size.
+ */
+class ResourcePool {
+public:
+    explicit ResourcePool(
+        const vku::Allocator &allocator
+    ) noexcept : allocator { allocator } { }
+
+    /**
+     * Get a persistently mapped buffer whose size is at least \p size.
+     */
+    [[nodiscard]] auto acquireBuffer(
+        vk::DeviceSize size,
+        vk::BufferUsageFlags usage
+    ) -> const vku::MappedBuffer & {
+        const vk::DeviceSize bucketSize = std::bit_ceil(size);
+        for (PooledBuffer &pooledBuffer : buffers) {
+            if (!pooledBuffer.inUse && pooledBuffer.size == bucketSize && pooledBuffer.usage == usage) {
+                pooledBuffer.inUse = true;
+                pooledBuffer.lastUsedJob = jobIndex;
+                return pooledBuffer.buffer;
+            }
+        }
+
+        buffers.push_back(PooledBuffer {
+            vku::MappedBuffer { vku::AllocatedBuffer { allocator, vk::BufferCreateInfo {
+                {},
+                bucketSize,
+                usage,
+            }, vma::AllocationCreateInfo {
+                vma::AllocationCreateFlagBits::eHostAccessRandom | vma::AllocationCreateFlagBits::eMapped,
+                vma::MemoryUsage::eAuto,
+            } } },
+            bucketSize,
+            usage,
+            true,
+            jobIndex,
+        });
+        pooledSize += bucketSize;
+        return buffers.back().buffer;
+    }
+
+    /**
+     * Get a device-local image created with \p createInfo.
+     */
+    [[nodiscard]] auto acquireImage(
+        const vk::ImageCreateInfo &createInfo
+    ) -> const vku::AllocatedImage & {
+        for (PooledImage &pooledImage : images) {
+            if (!pooledImage.inUse && pooledImage.createInfo == createInfo) {
+                pooledImage.inUse = true;
+                pooledImage.lastUsedJob = jobIndex;
+                return pooledImage.image;
+            }
+        }
+
+        // Size is estimated from the texel block size, as the allocation may be padded.
+        vk::DeviceSize size = 0;
+        for (std::uint32_t mipLevel : std::views::iota(0U, createInfo.mipLevels)) {
+            size += blockSize(createInfo.format)
+                * std::max(createInfo.extent.width >> mipLevel, 1U)
+                * std::max(createInfo.extent.height >> mipLevel, 1U)
+                * std::max(createInfo.extent.depth >> mipLevel, 1U)
+                * createInfo.arrayLayers;
+        }
+
+        images.push_back(PooledImage {
+            vku::AllocatedImage { allocator, createInfo, vma::AllocationCreateInfo {
+                {},
+                vma::MemoryUsage::eAutoPreferDevice,
+            } },
+            createInfo,
+            size,
+            true,
+            jobIndex,
+        });
+        pooledSize += size;
+        return images.back().image;
+    }
+
+    /**
+     * Mark every acquired resources as reusable, and destroy the least recently used ones until the total size of the
+     * pooled resources does not exceed \p maxPooledSize. They must not be used by the device anymore.
+     */
+    auto release(
+        vk::DeviceSize maxPooledSize
+    ) -> void {
+        for (PooledBuffer &pooledBuffer : buffers) {
+            pooledBuffer.inUse = false;
+        }
+        for (PooledImage &pooledImage : images) {
+            pooledImage.inUse = false;
+        }
+
+        while (pooledSize > maxPooledSize) {
+            // Resources acquired by the same job are evicted together.
+            const auto bufferIt = std::ranges::min_element(buffers, {}, &PooledBuffer::lastUsedJob);
+            const auto imageIt = std::ranges::min_element(images, {}, &PooledImage::lastUsedJob);
+            if (imageIt != images.end() && (bufferIt == buffers.end() || imageIt->lastUsedJob <= bufferIt->lastUsedJob)) {
+                pooledSize -= imageIt->size;
+                images.erase(imageIt);
+            }
+            else {
+                pooledSize -= bufferIt->size;
+                buffers.erase(bufferIt);
+            }
+        }
+
+        ++jobIndex;
+    }
+
+private:
+    struct PooledBuffer {
+        vku::MappedBuffer buffer;
+        vk::DeviceSize size;
+        vk::BufferUsageFlags usage;
+        bool inUse;
+        std::uint64_t lastUsedJob;
+    };
+
+    struct PooledImage {
+        vku::AllocatedImage image;
+        vk::ImageCreateInfo createInfo;
+        vk::DeviceSize size;
+        bool inUse;
+        std::uint64_t lastUsedJob;
+    };
+
+    const vku::Allocator &allocator;
+    vk::DeviceSize pooledSize = 0;
+    std::uint64_t jobIndex = 0;
+
+    // std::list for the reference stability.
+    std::list<PooledBuffer> buffers;
+    std::list<PooledImage> images;
+};
+
+/**
+ * Collect the command buffers recorded by multiple threads, and submit them with a single <tt>vkQueueSubmit</tt> in the
+ * submitting thread (which calls run()). A round is submitted when every participating thread has handed its command
+ * buffer, and the threads are blocked until their command buffers are executed.
+ */
+class CommandBatcher {
+public:
+    CommandBatcher(
+        vk::Queue queue,
+        std::size_t participantCount
+    ) noexcept : queue { queue },
+                 activeParticipantCount { participantCount } { }
+
+    /**
+     * Hand \p commandBuffer to the submitting thread, and wait until it is executed.
+     * @throw std::runtime_error If the submission failed.
+     */
+    auto submitAndWait(
+        vk::CommandBuffer commandBuffer
+    ) -> void {
+        std::unique_lock lock { mutex };
+        pendingCommandBuffers.push_back(commandBuffer);
+        const std::uint64_t round = completedRoundCount;
+        conditionVariable.notify_all();
+        conditionVariable.wait(lock, [&] { return completedRoundCount != round || failed; });
+        if (failed) {
+            throw std::runtime_error { "Batched submission failed" };
+        }
+    }
+
+    /**
+     * Notify that the calling thread will not hand any command buffer anymore.
+     */
+    auto leave() -> void {
+        {
+            std::scoped_lock lock { mutex };
+            --activeParticipantCount;
+        }
+        conditionVariable.notify_all();
+    }
+
+    /**
+     * Submit the rounds until every participating thread leaves.
+     */
+    auto run() -> void {
+        std::unique_lock lock { mutex };
+        while (true) {
+            conditionVariable.wait(lock, [&] { return pendingCommandBuffers.size() == activeParticipantCount; });
+            if (activeParticipantCount == 0) {
+                return;
+            }
+
+            try {
+                queue.submit(vk::SubmitInfo { {}, {}, pendingCommandBuffers });
+                queue.waitIdle();
+            }
+            catch (...) {
+                // Wake the participants up, so that they can leave.
+                failed = true;
+                conditionVariable.notify_all();
+                throw;
+            }
+
+            pendingCommandBuffers.clear();
+            ++completedRoundCount;
+            conditionVariable.notify_all();
+        }
+    }
+
+private:
+    vk::Queue queue;
+    std::mutex mutex;
+    std::condition_variable conditionVariable;
+    std::size_t activeParticipantCount;
+    std::vector<vk::CommandBuffer> pendingCommandBuffers;
+    std::uint64_t completedRoundCount = 0;
+    bool failed = false;
+};
+
+class MainApp : vku::Instance, vku::Gpu<QueueFamilyIndices, Queues> {
+public:
+    MainApp()
+        : Instance { createInstance() },
+          Gpu { createGpu() } { }
+
+    /**
+     * @param inputImage Image at <tt>options.imagePath</tt> if it is already loaded, e.g. while the instance and device
+     * are being created. If <tt>std::nullopt</tt>, it is loaded here.
+     */
+    auto run(
+        const Options &options,
+        std::optional<InputImage> inputImage = std::nullopt
+    ) -> void {
+        if (options.hizReductionMode) {
+            runHiZ(options, *options.hizReductionMode);
+            return;
+        }
+        if (!options.packedImagePaths.empty()) {
+            runPacked(options);
+            return;
+        }
+
+        for (Strategy strategy : options.strategies) {
+            if (!isSupported(getSubgroupMipmapVariant(strategy))) {
+                std::println("Device does not support the kernel of {}, falls back to {}.", getName(strategy), getName(Strategy::ComputeSubgroup));
+            }
+        }
+
+        // Load image, calculate the maximum mip levels.
+        const InputImage imageData = inputImage ? std::move(*inputImage) : InputImage { options.imagePath };
+        const vk::Extent3D baseImageExtent = [&] {
+            if (options.volume) {
+                // Depth slices are stacked vertically.
+                // Every level is exactly halved, so that the 4x4x4 workgroups of SubgroupVolumeMipmapComputer tile it.
+                if (imageData.width < 8 || !std::has_single_bit(static_cast<std::uint32_t>(imageData.width)) || imageData.height != imageData.width * imageData.width) {
+                    throw std::runtime_error { "Volume must be a cube whose dimension is a power of 2, and at least 8" };
+                }
+                return vk::Extent3D {
+                    static_cast<std::uint32_t>(imageData.width),
+                    static_cast<std::uint32_t>(imageData.width),
+                    static_cast<std::uint32_t>(imageData.width),
+                };
+            }
+            return vk::Extent3D { static_cast<std::uint32_t>(imageData.width), static_cast<std::uint32_t>(imageData.height), 1 };
+        }();
+        const std::uint32_t imageMipLevels = vku::Image::maxMipLevels(vk::Extent2D { baseImageExtent.width, baseImageExtent.height });
+
+        // Each strategy allocates a descriptor set, which is alive until the end of the run.
+        const vk::raii::DescriptorPool descriptorPool = createDescriptorPool(static_cast<std::uint32_t>(options.strategies.size()), imageMipLevels);
+
+        // Load image into staging buffer.
+        const vku::MappedBuffer &imageStagingBuffer = acquireStagingBuffer(std::as_bytes(imageData.getSpan()));
+
+        // Query pool for timestamp query.
+        const vk::raii::QueryPool queryPool = createQueryPool();
+
+        // Simulate the modification of the base level by inverting the texels in the dirty rect.
+        std::optional<vk::Buffer> dirtyRectStagingBuffer;
+        if (options.dirtyRect) {
+            const auto [offset, extent] = *options.dirtyRect;
+            // Compared in 64-bit, as the sums may overflow 32-bit.
+            if (static_cast<std::uint64_t>(offset.x) + extent.width > baseImageExtent.width
+                || static_cast<std::uint64_t>(offset.y) + extent.height > baseImageExtent.height) {
+                throw std::runtime_error { "Dirty rect must be inside the image" };
+            }
+
+            std::vector<std::uint8_t> modifiedTexels;
+            modifiedTexels.reserve(4 * static_cast<std::size_t>(extent.width) * extent.height);
+            for (std::uint32_t y : std::views::iota(static_cast<std::uint32_t>(offset.y), offset.y + extent.height)) {
+                const auto row = imageData.getSpan().subspan(4 * (static_cast<std::size_t>(y) * baseImageExtent.width + offset.x), 4 * extent.width);
+                for (std::size_t i = 0; i < row.size(); ++i) {
+                    // Invert RGB, preserve alpha.
+                    modifiedTexels.push_back(i % 4 == 3 ? row[i] : 255 - row[i]);
+                }
+            }
+            dirtyRectStagingBuffer = acquireStagingBuffer(std::as_bytes(std::span { modifiedTexels }));
+        }
+        const auto getRegionUpdate = [&]() -> std::optional<RegionUpdate> {
+            if (options.dirtyRect) {
+                return RegionUpdate { *options.dirtyRect, *dirtyRectStagingBuffer };
+            }
+            return std::nullopt;
+        };
+
+        // Determine the destaging buffer layout. If readback mip levels are not specified, all mip levels are copied
+        // into a 1.5x width atlas. Otherwise (or the image is volume), only the specified mip levels are copied back to
+        // back.
+        const vk::Extent2D destagingImageExtent { baseImageExtent.width * 3U / 2U, baseImageExtent.height };
+        const std::optional readbackMipLevels
+            = options.volume ? std::optional { options.readbackMipLevels.value_or(MipLevelRange { 0U, vk::RemainingMipLevels }) }
+            : options.readbackMipLevels;
+        std::vector<vk::BufferImageCopy> copyRegions;
+        vk::DeviceSize destagingBufferSize;
+        if (readbackMipLevels) {
+            const auto [baseMipLevel, levelCount] = *readbackMipLevels;
+            if (baseMipLevel >= imageMipLevels) {
+                throw std::runtime_error { std::format("Mip level {} does not exist (image has {} levels)", baseMipLevel, imageMipLevels) };
+            }
+
+            copyRegions = getPackedCopyRegions(
+                baseImageExtent, baseMipLevel,
+                std::min(levelCount, imageMipLevels - baseMipLevel));
+            const vk::Extent3D lastExtent = copyRegions.back().imageExtent;
+            destagingBufferSize = copyRegions.back().bufferOffset + blockSize(vk::Format::eR8G8B8A8Unorm) * lastExtent.width * lastExtent.height * lastExtent.depth;
+        }
+        else {
+            copyRegions = getAtlasCopyRegions(vk::Extent2D { baseImageExtent.width, baseImageExtent.height }, imageMipLevels, destagingImageExtent);
+            destagingBufferSize = blockSize(vk::Format::eR8G8B8A8Unorm) * destagingImageExtent.width * destagingImageExtent.height;
+        }
+
+        // Every strategy needs its own full mip chain image and destaging buffer. If they cannot be alive at the same
+        // time within the memory budget, strategies are executed one after another over a single image and a single
+        // destaging buffer.
+        const vk::DeviceSize imageSize = getMipChainSize(baseImageExtent, imageMipLevels);
+
+        bool budgeted = options.budgeted;
+        if (const std::optional memoryBudget = getMemoryBudget()) {
+            const auto fits = [&](std::size_t strategyCount) {
+                return strategyCount * imageSize <= memoryBudget->deviceLocal
+                    && strategyCount * (imageSize + destagingBufferSize) + imageData.getSpan().size_bytes() <= memoryBudget->total;
+            };
+
+            if (!budgeted && !fits(options.strategies.size())) {
+                std::println("Memory budget is insufficient for executing {} strategies at once, falling back to budgeted execution.", options.strategies.size());
+                budgeted = true;
+            }
+            if (budgeted && !fits(1)) {
+                throw std::runtime_error { std::format(
+                    "Memory budget (device local: {} bytes, total: {} bytes) is insufficient for the image (mip chain: {} bytes, destaging: {} bytes)",
+                    memoryBudget->deviceLocal, memoryBudget->total, imageSize, destagingBufferSize) };
+            }
+        }
+
+        const auto writeDestagingBuffer = [&](const vku::MappedBuffer &destagingBuffer, Strategy strategy) {
+            if (readbackMipLevels) {
+                // Depth slices of volume are stacked vertically.
+                for (const vk::BufferImageCopy &copyRegion : copyRegions) {
+                    stbi_write_png((options.outputDir / std::format("{}_mip{}.png", getName(strategy), copyRegion.imageSubresource.mipLevel)).string().c_str(),
+                        copyRegion.imageExtent.width, copyRegion.imageExtent.height * copyRegion.imageExtent.depth, 4,
+                        static_cast<const std::byte*>(destagingBuffer.data) + copyRegion.bufferOffset,
+                        blockSize(vk::Format::eR8G8B8A8Unorm) * copyRegion.imageExtent.width);
+                }
+            }
+            else {
+                stbi_write_png((options.outputDir / std::format("{}.png", getName(strategy))).string().c_str(),
+                    destagingImageExtent.width, destagingImageExtent.height, 4,
+                    destagingBuffer.data, blockSize(vk::Format::eR8G8B8A8Unorm) * destagingImageExtent.width);
+            }
+        };
+
+        if (budgeted) {
+            // Single image that can be used by all selected strategies, and single destaging buffer.
+            vk::ImageUsageFlags usage{};
+            for (Strategy strategy : options.strategies) {
+                usage |= getImageUsage(strategy);
+            }
+            const std::array<vku::Image, 1> baseImages { acquireBaseImage(baseImageExtent, imageMipLevels, usage) };
+            const vku::MappedBuffer &destagingBuffer = acquireDestagingBuffer(destagingBufferSize);
+
+            for (Strategy strategy : options.strategies) {
+                // Staging from imageStagingBuffer to the image. Previous strategy's result is discarded.
+                vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+                    recordStagingCommands(commandBuffer, imageStagingBuffer, baseImages);
+                });
+                queues.computeGraphics.waitIdle();
+
+                generateMipmaps(strategy, get<0>(baseImages), RecordingContext { *computeGraphicsCommandPool, *descriptorPool, queryPool }, getRegionUpdate());
+
+                // Copy from the image to the destaging buffer, and write it before the next strategy overwrites it.
+                vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+                    recordDestagingCommands(commandBuffer, baseImages, std::array { getWriteScope(strategy) }, std::array<vk::Buffer, 1> { destagingBuffer }, copyRegions);
+                });
+                queues.computeGraphics.waitIdle();
+
+                writeDestagingBuffer(destagingBuffer, strategy);
+            }
+        }
+        else {
+            // Create device-local images for each strategy (each images have different usage).
+            const std::vector baseImages
+                = options.strategies
+                | std::views::transform([&](Strategy strategy) -> vku::Image {
+                    return acquireBaseImage(baseImageExtent, imageMipLevels, getImageUsage(strategy));
+                })
+                | std::ranges::to<std::vector>();
+
+            // Staging from imageStagingBuffer to baseImages.
+            vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+                recordStagingCommands(commandBuffer, imageStagingBuffer, baseImages);
+            });
+            queues.computeGraphics.waitIdle();
+
+            if (const std::uint32_t threadCount = std::min<std::uint32_t>(options.recordingThreadCount, options.strategies.size()); threadCount > 1U) {
+                const auto startTime = std::chrono::steady_clock::now();
+                generateMipmapsParallel(options.strategies, baseImages, getRegionUpdate(), threadCount);
+                std::println("Recording and execution of {} strategies with {} threads: {} us (host)",
+                    options.strategies.size(), threadCount,
+                    std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - startTime).count());
+            }
+            else {
+                const RecordingContext context { *computeGraphicsCommandPool, *descriptorPool, queryPool };
+                for (const auto &[strategy, baseImage] : std::views::zip(options.strategies, baseImages)) {
+                    generateMipmaps(strategy, baseImage, context, getRegionUpdate());
+                }
+            }
+
+            // Create host buffers for destaging.
+            const std::vector<std::reference_wrapper<const vku::MappedBuffer>> destagingBuffers
+                = baseImages
+                | std::views::transform([&](const auto&) { return std::cref(acquireDestagingBuffer(destagingBufferSize)); })
+                | std::ranges::to<std::vector>();
+
+            // Copy from baseImages to destagingBuffers.
+            vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+                recordDestagingCommands(
+                    commandBuffer,
+                    baseImages,
+                    options.strategies | std::views::transform(getWriteScope) | std::ranges::to<std::vector>(),
+                    destagingBuffers
+                        | std::views::transform([](const vku::MappedBuffer &buffer) -> vk::Buffer { return buffer; })
+                        | std::ranges::to<std::vector>(),
+                    copyRegions);
+            });
+            queues.computeGraphics.waitIdle();
+
+            for (const auto &[destagingBuffer, strategy] : std::views::zip(destagingBuffers, options.strategies)) {
+                writeDestagingBuffer(destagingBuffer, strategy);
+            }
+        }
+    }
+
+    /**
+     * Initialize once, and execute the jobs received over the Unix domain socket at \p socketPath until the process is
+     * terminated. Pipelines, images and buffers are reused across the jobs.
+     *
+     * A job is the command line arguments of the one-shot execution, each terminated by a null character (see
+     * <tt>client.cpp</tt>). After the client shuts down its writing side, the job is executed and <tt>ok</tt> or
+     * <tt>error: <message></tt> is sent back.
+     */
+    auto serve(
+        const std::filesystem::path &socketPath
+    ) -> void {
+#ifdef MIPMAP_SERVER_SUPPORTED
+        // Client may disconnect before reading the response.
+        std::signal(SIGPIPE, SIG_IGN);
+
+        sockaddr_un address { .sun_family = AF_UNIX };
+        const std::string socketPathString = socketPath.string();
+        if (socketPathString.size() >= sizeof(address.sun_path)) {
+            throw std::runtime_error { std::format("Socket path is too long: {}", socketPathString) };
+        }
+        std::ranges::copy(socketPathString, address.sun_path);
+
+        const int listenSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenSocket == -1) {
+            throw std::system_error { errno, std::generic_category(), "Failed to create socket" };
+        }
+
+        // Remove the socket file left by the previous server.
+        unlink(socketPathString.c_str());
+        if (bind(listenSocket, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 || listen(listenSocket, SOMAXCONN) == -1) {
+            const int error = errno;
+            close(listenSocket);
+            throw std::system_error { error, std::generic_category(), std::format("Failed to listen on {}", socketPathString) };
+        }
+        std::println("Listening on {}", socketPathString);
+
+        // Pooled resources are kept up to the quarter of the largest device-local heap, so that varying jobs do not
+        // exhaust the device memory.
+        vk::DeviceSize maxPooledSize = 0;
+        const vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
+        for (const vk::MemoryHeap &memoryHeap : std::span { memoryProperties.memoryHeaps.data(), memoryProperties.memoryHeapCount }) {
+            if (memoryHeap.flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+                maxPooledSize = std::max(maxPooledSize, memoryHeap.size / 4);
+            }
+        }
+
+        while (true) {
+            const int connection = accept(listenSocket, nullptr, nullptr);
+            if (connection == -1) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                const int error = errno;
+                close(listenSocket);
+                throw std::system_error { error, std::generic_category(), "Failed to accept connection" };
+            }
+
+            // Read until the client shuts down its writing side.
+            std::string request;
+            std::array<char, 4096> chunk;
+            for (ssize_t readSize; (readSize = read(connection, chunk.data(), chunk.size())) > 0;) {
+                request.append(chunk.data(), readSize);
+            }
+
+            std::string response = "ok\n";
+            try {
+                if (request.ends_with('\0')) {
+                    request.pop_back();
+                }
+                const std::vector args
+                    = request
+                    | std::views::split('\0')
+                    | std::views::transform([](auto &&arg) { return std::string { std::string_view { arg } }; })
+                    | std::ranges::to<std::vector>();
+                const std::vector argPtrs
+                    = args
+                    | std::views::transform([](const std::string &arg) { return arg.c_str(); })
+                    | std::ranges::to<std::vector>();
+
+                const Options options = Options::parse(argPtrs);
+                if (options.serveSocketPath) {
+                    throw std::invalid_argument { "Job cannot start another server" };
+                }
+                run(options);
+            }
+            catch (const std::exception &e) {
+                response = std::format("error: {}\n", e.what());
+            }
+
+            // Every resources are reusable by the next job.
+            device.waitIdle();
+            resourcePool.release(maxPooledSize);
+
+            // Response is best effort, as the client may already be gone.
+            [[maybe_unused]] const ssize_t writtenSize = write(connection, response.data(), response.size());
+            close(connection);
+        }
+#else
+        throw std::runtime_error { std::format("Server mode is not supported on this platform (socket path: {})", socketPath.string()) };
+#endif
+    }
+
+private:
+    struct MemoryBudget {
+        vk::DeviceSize deviceLocal; // Available size of the largest device-local heap.
+        vk::DeviceSize total;       // Available size of all heaps.
+    };
+
+    struct RegionUpdate {
+        vk::Rect2D rect;
+        vk::Buffer stagingBuffer; // Tightly packed texels of rect.
+    };
+
+    // Objects used by generateMipmaps for recording. Each recording thread has its own, as they are externally synchronized.
+    struct RecordingContext {
+        vk::CommandPool commandPool;
+        vk::DescriptorPool descriptorPool;
+        const vk::raii::QueryPool &queryPool;
+        // If not null, command buffers are submitted through it. Otherwise, they are submitted directly.
+        CommandBatcher *batcher = nullptr;
+    };
+
+    // Whether shaderFloat16 and shaderSubgroupExtendedTypes features are enabled.
+    bool float16Supported = isFloat16Supported();
+
+    vku::Allocator allocator = createAllocator();
+    vk::raii::CommandPool computeGraphicsCommandPool = createCommandPool(queueFamilyIndices.computeGraphics);
+    ResourcePool resourcePool { allocator };
+
+    // Pipelines are cached by their mip image count to be reused across the jobs.
+    std::map<std::uint32_t, MipmapComputer> mipmapComputers;
+    std::array<std::map<std::uint32_t, SubgroupMipmapComputer>, 4> subgroupMipmapComputers; // Indexed by SubgroupMipmapComputer::Variant.
+    std::map<std::uint32_t, VolumeMipmapComputer> volumeMipmapComputers;
+    std::map<std::uint32_t, SubgroupVolumeMipmapComputer> subgroupVolumeMipmapComputers;
+    std::map<std::uint32_t, SubgroupHiZComputer> subgroupHiZComputers;
+    mutable std::mutex computersMutex;
+
+    /**
+     * Generate Hi-Z pyramid of the depth image at <tt>options.imagePath</tt> (only the first channel is used), and write
+     * each pyramid level as <tt>hiz_<mode>_mip<level>.png</tt>, where level is counted from the depth image (level 0).
+     * For ReductionMode::MinMax, minimum and maximum are written into red and green channels respectively.
+     */
+    auto runHiZ(
+        const Options &options,
+        SubgroupHiZComputer::ReductionMode reductionMode
+    ) -> void {
+        // Load depth as linear [0, 1] values.
+        stbi_ldr_to_hdr_gamma(1.f);
+        const ImageData depthData = loadImageData<float>(options.imagePath, 1);
+        const vk::Extent2D depthImageExtent { static_cast<std::uint32_t>(depthData.width), static_cast<std::uint32_t>(depthData.height) };
+        // Like SubgroupMipmapComputer, every workgroup must be fully inside the image, as out of bounds texels would be
+        // mixed into the reduction.
+        // Non-square images are also rejected, as the workgroups of the shorter axis would run out of the image at the
+        // last levels.
+        if (depthImageExtent.width != depthImageExtent.height || !std::has_single_bit(depthImageExtent.width) || depthImageExtent.width < 32U) {
+            throw std::runtime_error { std::format("Depth image must be a square whose dimension is a power of 2, and at least 32 (got {}x{})", depthImageExtent.width, depthImageExtent.height) };
+        }
+        const std::uint32_t depthMipLevels = vku::Image::maxMipLevels(depthImageExtent);
+
+        const vku::MappedBuffer &depthStagingBuffer = acquireStagingBuffer(std::as_bytes(depthData.getSpan()));
+
+        const vku::AllocatedImage &depthImage = resourcePool.acquireImage(vk::ImageCreateInfo {
+            {},
+            vk::ImageType::e2D,
+            vk::Format::eR32Sfloat,
+            vk::Extent3D { depthImageExtent, 1 },
+            1, 1,
+            vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eTransferDst /* staging dst */ | vk::ImageUsageFlagBits::eSampled,
+        });
+
+        // Pyramid's level 0 is the depth image's level 1.
+        const vk::Format pyramidFormat = reductionMode == SubgroupHiZComputer::ReductionMode::MinMax ? vk::Format::eR32G32Sfloat : vk::Format::eR32Sfloat;
+        const vku::AllocatedImage &pyramidImage = resourcePool.acquireImage(vk::ImageCreateInfo {
+            {},
+            vk::ImageType::e2D,
+            pyramidFormat,
+            vk::Extent3D { vku::Image::mipExtent(depthImageExtent, 1), 1 },
+            depthMipLevels - 1U, 1,
+            vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eStorage | vk::ImageUsageFlagBits::eTransferSrc /* destaging src */,
+        });
+
+        const vk::raii::ImageView depthImageView { device, vk::ImageViewCreateInfo {
+            {},
+            depthImage,
+            vk::ImageViewType::e2D,
+            depthImage.format,
+            {},
+            vku::fullSubresourceRange(),
+        } };
+        const std::vector pyramidMipViews
+            = std::views::iota(0U, pyramidImage.mipLevels)
+            | std::views::transform([&](std::uint32_t mipLevel) {
+                return vk::raii::ImageView { device, vk::ImageViewCreateInfo {
+                    {},
+                    pyramidImage,
+                    vk::ImageViewType::e2D,
+                    pyramidImage.format,
+                    {},
+                    { vk::ImageAspectFlagBits::eColor, mipLevel, 1, 0, 1 },
+                } };
+            })
+            | std::ranges::to<std::vector>();
+
+        const std::uint32_t subgroupSize
+            = physicalDevice.getProperties2<
+                vk::PhysicalDeviceProperties2,
+                vk::PhysicalDeviceSubgroupProperties>()
+            .get<vk::PhysicalDeviceSubgroupProperties>()
+            .subgroupSize;
+        const SubgroupHiZComputer &subgroupHiZComputer = getComputer(subgroupHiZComputers, pyramidImage.mipLevels, subgroupSize);
+        const vk::raii::DescriptorPool descriptorPool = createDescriptorPool(1, pyramidImage.mipLevels);
+        const SubgroupHiZComputer::DescriptorSets descriptorSets { *device, *descriptorPool, subgroupHiZComputer.descriptorSetLayouts };
+        device.updateDescriptorSets(
+            descriptorSets.getDescriptorWrites0(*depthImageView, pyramidMipViews | ranges::views::deref).get(),
+            {});
+
+        // Upload the depth and make it shader readable.
+        vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+            const vk::ImageMemoryBarrier2 preCopyBarrier {
+                vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                {}, vk::ImageLayout::eTransferDstOptimal,
+                vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                depthImage,
+                vku::fullSubresourceRange(),
+            };
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, preCopyBarrier });
+            commandBuffer.copyBufferToImage(
+                depthStagingBuffer,
+                depthImage, vk::ImageLayout::eTransferDstOptimal,
+                vk::BufferImageCopy {
+                    0, 0, 0,
+                    { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+                    { 0, 0, 0 },
+                    depthImage.extent,
+                });
+            const vk::ImageMemoryBarrier2 postCopyBarrier {
+                vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderSampledRead,
+                vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eShaderReadOnlyOptimal,
+                vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                depthImage,
+                vku::fullSubresourceRange(),
+            };
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, postCopyBarrier });
+        });
+        queues.computeGraphics.waitIdle();
 
-#define INDEX_SEQ(Is, N, ...)                          \
-    [&]<std::size_t... Is>(std::index_sequence<Is...>) \
-        __VA_ARGS__                                    \
-    (std::make_index_sequence<N>{})
-#define ARRAY_OF(N, ...)                            \
-    INDEX_SEQ(Is, N, {                              \
-        return std::array { (Is, __VA_ARGS__)... }; \
-    })
-#define FWD(...) static_cast<decltype(__VA_ARGS__) &&>(__VA_ARGS__)
+        // Query pool for timestamp query.
+        const vk::raii::QueryPool queryPool = createQueryPool();
+        executeTimedCommand(RecordingContext { *computeGraphicsCommandPool, *descriptorPool, queryPool }, std::format("Hi-Z pyramid generation ({}) with subgroup operation", getName(reductionMode)), [&](vk::CommandBuffer commandBuffer) {
+            const vk::ImageMemoryBarrier2 imageMemoryBarrier {
+                vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+                {}, vk::ImageLayout::eGeneral,
+                vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                pyramidImage,
+                vku::fullSubresourceRange(),
+            };
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarrier });
+            subgroupHiZComputer.compute(commandBuffer, descriptorSets, depthImageExtent, depthMipLevels, reductionMode);
+        });
 
-struct QueueFamilyIndices {
-    std::uint32_t computeGraphics;
+        // Read back every pyramid level, tightly packed.
+        const std::vector copyRegions = getPackedCopyRegions(pyramidImage.extent, 0, pyramidImage.mipLevels, pyramidFormat);
+        const vk::Extent3D lastExtent = copyRegions.back().imageExtent;
+        const vku::MappedBuffer &destagingBuffer
+            = acquireDestagingBuffer(copyRegions.back().bufferOffset + blockSize(pyramidFormat) * lastExtent.width * lastExtent.height);
+        vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+            recordDestagingCommands(
+                commandBuffer,
+                std::array<vku::Image, 1> { pyramidImage },
+                std::array { WriteScope { vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite } },
+                std::array<vk::Buffer, 1> { destagingBuffer },
+                copyRegions);
+        });
+        queues.computeGraphics.waitIdle();
 
-    explicit QueueFamilyIndices(
-        vk::PhysicalDevice physicalDevice
-    ) {
-        for (auto [queueFamilyIndex, properties] : physicalDevice.getQueueFamilyProperties() | ranges::views::enumerate) {
-            if (properties.queueFlags & vk::QueueFlagBits::eCompute && properties.queueFlags & vk::QueueFlagBits::eGraphics) {
-                computeGraphics = queueFamilyIndex;
-                return;
+        // Quantize the reduced depths into 8-bit.
+        const std::uint32_t channels = reductionMode == SubgroupHiZComputer::ReductionMode::MinMax ? 2U : 1U;
+        for (const vk::BufferImageCopy &copyRegion : copyRegions) {
+            const std::span reducedDepths {
+                reinterpret_cast<const float*>(static_cast<const std::byte*>(destagingBuffer.data) + copyRegion.bufferOffset),
+                channels * copyRegion.imageExtent.width * copyRegion.imageExtent.height,
+            };
+
+            // Min and max are written as grayscale, min-max is written as (min, max, 0).
+            const std::uint32_t outputChannels = channels == 1U ? 1U : 3U;
+            std::vector<std::uint8_t> texels(outputChannels * copyRegion.imageExtent.width * copyRegion.imageExtent.height, 0);
+            for (std::size_t i = 0; i < reducedDepths.size(); ++i) {
+                texels[outputChannels * (i / channels) + i % channels] = static_cast<std::uint8_t>(std::clamp(reducedDepths[i], 0.f, 1.f) * 255.f + 0.5f);
             }
-        }
 
-        throw std::runtime_error { "Physical device doesn't have compute-graphics queue family" };
+            stbi_write_png((options.outputDir / std::format("hiz_{}_mip{}.png", getName(reductionMode), copyRegion.imageSubresource.mipLevel + 1U)).string().c_str(),
+                copyRegion.imageExtent.width, copyRegion.imageExtent.height, outputChannels,
+                texels.data(), outputChannels * copyRegion.imageExtent.width);
+        }
     }
-};
 
-struct Queues {
-    vk::Queue computeGraphics;
+    /**
+     * Pack the images at <tt>options.packedImagePaths</tt> into the layers of array images, one per distinct extent, and
+     * mipmap all of them in a single command buffer, with a single subgroup dispatch chain per array image. Each image is
+     * sliced back out as <tt><stem>_mip<level>.png</tt>.
+     */
+    auto runPacked(
+        const Options &options
+    ) -> void {
+        // Output files are named by the image stems, so they must be distinct.
+        std::set<std::filesystem::path> stems;
+        for (const std::filesystem::path &path : options.packedImagePaths) {
+            if (!stems.insert(path.stem()).second) {
+                throw std::runtime_error { std::format("Packed images must have distinct file names, but {} is duplicated: {}", path.stem().string(), path.string()) };
+            }
+        }
 
-    Queues(
-        vk::Device device,
-        const QueueFamilyIndices &queueFamilyIndices
-    ) : computeGraphics { device.getQueue(queueFamilyIndices.computeGraphics, 0) } { }
+        const std::vector imageDatas = loadInputImages(options.packedImagePaths);
 
-    [[nodiscard]] static auto getDeviceQueueCreateInfos(
-        const QueueFamilyIndices &queueFamilyIndices
-    ) -> std::array<vk::DeviceQueueCreateInfo, 1> {
-        static constexpr std::array queuePriorities { 1.f };
-        return std::array {
-            vk::DeviceQueueCreateInfo { {}, queueFamilyIndices.computeGraphics, queuePriorities },
+        // Group the images by extent. If a group exceeds the array layer limit, another group is made.
+        struct PackedGroup {
+            vk::Extent2D extent;
+            std::vector<std::size_t> imageIndices;
         };
-    }
-};
+        const std::uint32_t maxArrayLayers = physicalDevice.getProperties().limits.maxImageArrayLayers;
+        std::vector<PackedGroup> groups;
+        for (const auto &[imageIndex, imageData] : imageDatas | ranges::views::enumerate) {
+            const vk::Extent2D extent { static_cast<std::uint32_t>(imageData.width), static_cast<std::uint32_t>(imageData.height) };
+            // SubgroupMipmapComputer only tiles the square power of 2 extents.
+            if (extent.width != extent.height || !std::has_single_bit(extent.width) || extent.width < 32U) {
+                throw std::runtime_error { std::format(
+                    "Packed image must be a square whose dimension is a power of 2, and at least 32 (got {}x{}): {}",
+                    extent.width, extent.height, options.packedImagePaths[imageIndex].string()) };
+            }
 
-class MainApp : vku::Instance, vku::Gpu<QueueFamilyIndices, Queues> {
-public:
-    MainApp()
-        : Instance { createInstance() },
-          Gpu { createGpu() } { }
+            auto it = std::ranges::find_if(groups, [&](const PackedGroup &group) {
+                return group.extent == extent && group.imageIndices.size() < maxArrayLayers;
+            });
+            if (it == groups.end()) {
+                it = groups.insert(groups.end(), PackedGroup { extent, {} });
+            }
+            it->imageIndices.push_back(imageIndex);
+        }
 
-    auto run(
-        const std::filesystem::path &imagePath,
-        const std::filesystem::path &outputDir
-    ) const -> void {
-        // Load image, calculate the maximum mip levels.
-        const ImageData<std::uint8_t> imageData { imagePath.string().c_str(), 4 };
-        const vk::Extent2D baseImageExtent { static_cast<std::uint32_t>(imageData.width), static_cast<std::uint32_t>(imageData.height) };
-        const std::uint32_t imageMipLevels = vku::Image::maxMipLevels(baseImageExtent);
+        const auto startTime = std::chrono::steady_clock::now();
 
-        // Load image into staging buffer.
-        const vku::MappedBuffer imageStagingBuffer {
-            allocator,
-            std::from_range, imageData.getSpan(),
-            vk::BufferUsageFlagBits::eTransferSrc, /* staging src */
+        // Array images, and their staging/destaging layouts.
+        struct PackedImage {
+            vku::Image image;
+            std::uint32_t layerCount;
+            vk::DeviceSize stagingOffset;
+            std::vector<vk::BufferImageCopy> copyRegions; // Destaging regions, each of them has all layers of a mip level.
         };
+        std::vector<PackedImage> packedImages;
+        vk::DeviceSize stagingBufferSize = 0;
+        vk::DeviceSize destagingBufferSize = 0;
+        for (const PackedGroup &group : groups) {
+            const vk::Extent3D extent { group.extent, 1 };
+            const std::uint32_t mipLevels = vku::Image::maxMipLevels(group.extent);
+            const auto layerCount = static_cast<std::uint32_t>(group.imageIndices.size());
 
-        // Create 3 device-local images (each images have different usage).
-        const auto createBaseImage = [&](vk::ImageUsageFlags usage) {
-            return vku::AllocatedImage { allocator, vk::ImageCreateInfo {
-                {},
-                vk::ImageType::e2D,
-                vk::Format::eR8G8B8A8Unorm,
-                vk::Extent3D { baseImageExtent, 1 },
-                imageMipLevels, 1,
-                vk::SampleCountFlagBits::e1,
-                vk::ImageTiling::eOptimal,
-                vk::ImageUsageFlagBits::eTransferDst /* staging dst */
-                    | usage
-                    | vk::ImageUsageFlagBits::eTransferSrc /* destaging src */,
-            }, vma::AllocationCreateInfo {
-                {},
-                vma::MemoryUsage::eAutoPreferDevice,
-            } };
-        };
-        const std::array baseImages {
-            createBaseImage(vk::ImageUsageFlagBits::eTransferSrc | vk::ImageUsageFlagBits::eTransferDst), // For blit-based mipmap generation.
-            createBaseImage(vk::ImageUsageFlagBits::eStorage), // For compute shader mipmap generation with per-level barriers.
-            createBaseImage(vk::ImageUsageFlagBits::eStorage), // For compute shader mipmap generation with subgroup operation.
-        };
+            const auto [baseMipLevel, levelCount] = options.readbackMipLevels.value_or(MipLevelRange { 0U, vk::RemainingMipLevels });
+            if (baseMipLevel >= mipLevels) {
+                throw std::runtime_error { std::format("Mip level {} does not exist ({}x{} image has {} levels)", baseMipLevel, extent.width, extent.height, mipLevels) };
+            }
+            std::vector<vk::BufferImageCopy> copyRegions;
+            for (std::uint32_t mipLevel : std::views::iota(baseMipLevel, baseMipLevel + std::min(levelCount, mipLevels - baseMipLevel))) {
+                const vk::Extent3D mipExtent = getMipExtent(extent, mipLevel);
+                copyRegions.push_back(vk::BufferImageCopy {
+                    destagingBufferSize, 0, 0,
+                    { vk::ImageAspectFlagBits::eColor, mipLevel, 0, layerCount },
+                    { 0, 0, 0 },
+                    mipExtent,
+                });
+                destagingBufferSize += blockSize(vk::Format::eR8G8B8A8Unorm) * mipExtent.width * mipExtent.height * layerCount;
+            }
+
+            packedImages.push_back(PackedImage {
+                resourcePool.acquireImage(vk::ImageCreateInfo {
+                    {},
+                    vk::ImageType::e2D,
+                    vk::Format::eR8G8B8A8Unorm,
+                    extent,
+                    mipLevels, layerCount,
+                    vk::SampleCountFlagBits::e1,
+                    vk::ImageTiling::eOptimal,
+                    vk::ImageUsageFlagBits::eTransferDst /* staging dst */
+                        | vk::ImageUsageFlagBits::eStorage
+                        | vk::ImageUsageFlagBits::eTransferSrc /* destaging src */,
+                }),
+                layerCount,
+                stagingBufferSize,
+                std::move(copyRegions),
+            });
+            stagingBufferSize += blockSize(vk::Format::eR8G8B8A8Unorm) * extent.width * extent.height * layerCount;
+        }
+
+        // Layers of an array image are placed back to back in the staging buffer.
+        const vku::MappedBuffer &stagingBuffer = resourcePool.acquireBuffer(stagingBufferSize, vk::BufferUsageFlagBits::eTransferSrc /* staging src */);
+        for (const auto &[group, packedImage] : std::views::zip(groups, packedImages)) {
+            for (const auto &[layer, imageIndex] : group.imageIndices | ranges::views::enumerate) {
+                const std::span texels = std::as_bytes(imageDatas[imageIndex].getSpan());
+                std::ranges::copy(texels, static_cast<std::byte*>(stagingBuffer.data) + packedImage.stagingOffset + layer * texels.size_bytes());
+            }
+        }
 
-        // Staging from imageStagingBuffer to baseImages[0..3].
         vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
-            commandBuffer.pipelineBarrier(
-                vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
-                {}, {}, {},
-                std::apply([](const auto &...images) {
-                    return std::array {
-                        vk::ImageMemoryBarrier {
-                            {}, vk::AccessFlagBits::eTransferWrite,
-                            {}, vk::ImageLayout::eTransferDstOptimal,
-                            vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
-                            images,
-                            { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
-                        }...
+            const std::vector imageMemoryBarriers
+                = packedImages
+                | std::views::transform([](const PackedImage &packedImage) {
+                    return vk::ImageMemoryBarrier2 {
+                        vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                        vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                        {}, vk::ImageLayout::eTransferDstOptimal,
+                        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                        packedImage.image,
+                        { vk::ImageAspectFlagBits::eColor, 0, 1, 0, vk::RemainingArrayLayers },
                     };
-                }, baseImages));
+                })
+                | std::ranges::to<std::vector>();
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarriers });
 
-            for (const vku::Image &baseImage : baseImages) {
+            for (const PackedImage &packedImage : packedImages) {
                 commandBuffer.copyBufferToImage(
-                    imageStagingBuffer,
-                    baseImage, vk::ImageLayout::eTransferDstOptimal,
+                    stagingBuffer,
+                    packedImage.image, vk::ImageLayout::eTransferDstOptimal,
                     vk::BufferImageCopy {
-                        0, 0, 0,
-                        { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+                        packedImage.stagingOffset, 0, 0,
+                        { vk::ImageAspectFlagBits::eColor, 0, 0, packedImage.layerCount },
                         { 0, 0, 0 },
-                        baseImage.extent,
+                        packedImage.image.extent,
                     });
             }
         });
         queues.computeGraphics.waitIdle();
 
-        // Query pool for timestamp query.
-        const vk::raii::QueryPool queryPool { device, vk::QueryPoolCreateInfo {
-            {},
-            vk::QueryType::eTimestamp,
-            2,
-        } };
-        const auto printElapsedTime = [&queryPool, timestampPeriod = physicalDevice.getProperties().limits.timestampPeriod](std::string_view label) {
-            const auto [result, timestamps] = queryPool.getResults<std::uint64_t>(
-                0, 2, 2 * sizeof(std::uint64_t), sizeof(std::uint64_t), vk::QueryResultFlagBits::e64);
-            if (result == vk::Result::eSuccess) {
-                std::println("{}: {} us", label, (timestamps[1] - timestamps[0]) * timestampPeriod / 1e3f);
+        // Prepare the pipelines and descriptor sets of every array images.
+        const std::uint32_t subgroupSize
+            = physicalDevice.getProperties2<
+                vk::PhysicalDeviceProperties2,
+                vk::PhysicalDeviceSubgroupProperties>()
+            .get<vk::PhysicalDeviceSubgroupProperties>()
+            .subgroupSize;
+        const vk::raii::DescriptorPool packedDescriptorPool = createDescriptorPool(
+            static_cast<std::uint32_t>(packedImages.size()),
+            std::ranges::max(packedImages | std::views::transform([](const PackedImage &packedImage) { return packedImage.image.mipLevels; })));
+        std::vector<std::reference_wrapper<const SubgroupMipmapComputer>> computers;
+        std::vector<std::vector<vk::raii::ImageView>> imageMipViews;
+        std::list<SubgroupMipmapComputer::DescriptorSets> descriptorSets;
+        for (const PackedImage &packedImage : packedImages) {
+            const SubgroupMipmapComputer &computer = computers.emplace_back(getComputer(subgroupMipmapComputers[std::to_underlying(SubgroupMipmapComputer::Variant::Shuffle)], packedImage.image.mipLevels, subgroupSize));
+            const std::vector<vk::raii::ImageView> &mipViews = imageMipViews.emplace_back(
+                std::views::iota(0U, packedImage.image.mipLevels)
+                    | std::views::transform([&](std::uint32_t mipLevel) {
+                        return vk::raii::ImageView { device, vk::ImageViewCreateInfo {
+                            {},
+                            packedImage.image,
+                            vk::ImageViewType::e2DArray,
+                            packedImage.image.format,
+                            {},
+                            { vk::ImageAspectFlagBits::eColor, mipLevel, 1, 0, vk::RemainingArrayLayers },
+                        } };
+                    })
+                    | std::ranges::to<std::vector>());
+            device.updateDescriptorSets(
+                descriptorSets.emplace_back(*device, *packedDescriptorPool, computer.descriptorSetLayouts)
+                    .getDescriptorWrites0(mipViews | ranges::views::deref).get(),
+                {});
+        }
+
+        const vk::raii::QueryPool queryPool = createQueryPool();
+        executeTimedCommand(
+            RecordingContext { *computeGraphicsCommandPool, *packedDescriptorPool, queryPool },
+            std::format("Packed compute shader mipmap generation with subgroup operation ({} images in {} array images)", imageDatas.size(), packedImages.size()),
+            [&](vk::CommandBuffer commandBuffer) {
+                // Base level is written by the staging, and the other levels are fully overwritten.
+                std::vector<vk::ImageMemoryBarrier2> imageMemoryBarriers;
+                for (const PackedImage &packedImage : packedImages) {
+                    imageMemoryBarriers.push_back({
+                        vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead,
+                        vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eGeneral,
+                        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                        packedImage.image,
+                        { vk::ImageAspectFlagBits::eColor, 0, 1, 0, vk::RemainingArrayLayers },
+                    });
+                    imageMemoryBarriers.push_back({
+                        vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite,
+                        {}, vk::ImageLayout::eGeneral,
+                        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                        packedImage.image,
+                        { vk::ImageAspectFlagBits::eColor, 1, vk::RemainingMipLevels, 0, vk::RemainingArrayLayers },
+                    });
+                }
+                commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarriers });
+
+                // Array images are independent, therefore no barrier is needed between their dispatch chains.
+                for (const auto &[packedImage, computer, descriptorSet] : std::views::zip(packedImages, computers, descriptorSets)) {
+                    const vk::Extent2D baseImageExtent { packedImage.image.extent.width, packedImage.image.extent.height };
+                    computer.get().compute(
+                        commandBuffer, descriptorSet, baseImageExtent, packedImage.image.mipLevels,
+                        vk::Rect2D { {}, baseImageExtent }, packedImage.layerCount);
+                }
+            });
+
+        // Read back the mip levels of every array images into a single destaging buffer.
+        const vku::MappedBuffer &destagingBuffer = acquireDestagingBuffer(destagingBufferSize);
+        vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
+            const std::vector imageMemoryBarriers
+                = packedImages
+                | std::views::transform([](const PackedImage &packedImage) {
+                    return vk::ImageMemoryBarrier2 {
+                        vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+                        vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferRead,
+                        vk::ImageLayout::eGeneral, vk::ImageLayout::eTransferSrcOptimal,
+                        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                        packedImage.image,
+                        vku::fullSubresourceRange(),
+                    };
+                })
+                | std::ranges::to<std::vector>();
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarriers });
+
+            for (const PackedImage &packedImage : packedImages) {
+                commandBuffer.copyImageToBuffer(
+                    packedImage.image, vk::ImageLayout::eTransferSrcOptimal,
+                    destagingBuffer,
+                    packedImage.copyRegions);
             }
-            else {
-                std::println(std::cerr, "Failed to get timestamp query: {}", to_string(result));
+        });
+        queues.computeGraphics.waitIdle();
+
+        const std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+        std::println("Packed mipmap generation of {} images: {} us (host), {:.0f} images/s",
+            imageDatas.size(),
+            std::chrono::duration_cast<std::chrono::microseconds>(elapsedTime).count(),
+            imageDatas.size() / elapsedTime.count());
+
+        // Slice every image out of the array images.
+        for (const auto &[group, packedImage] : std::views::zip(groups, packedImages)) {
+            for (const vk::BufferImageCopy &copyRegion : packedImage.copyRegions) {
+                const vk::DeviceSize layerSize = blockSize(vk::Format::eR8G8B8A8Unorm) * copyRegion.imageExtent.width * copyRegion.imageExtent.height;
+                for (const auto &[layer, imageIndex] : group.imageIndices | ranges::views::enumerate) {
+                    stbi_write_png((options.outputDir / std::format("{}_mip{}.png", options.packedImagePaths[imageIndex].stem().string(), copyRegion.imageSubresource.mipLevel)).string().c_str(),
+                        copyRegion.imageExtent.width, copyRegion.imageExtent.height, 4,
+                        static_cast<const std::byte*>(destagingBuffer.data) + copyRegion.bufferOffset + layer * layerSize,
+                        blockSize(vk::Format::eR8G8B8A8Unorm) * copyRegion.imageExtent.width);
+                }
             }
+        }
+    }
+
+    [[nodiscard]] auto acquireBaseImage(
+        const vk::Extent3D &extent,
+        std::uint32_t mipLevels,
+        vk::ImageUsageFlags usage
+    ) -> const vku::AllocatedImage & {
+        return resourcePool.acquireImage(vk::ImageCreateInfo {
+            {},
+            extent.depth == 1U ? vk::ImageType::e2D : vk::ImageType::e3D,
+            vk::Format::eR8G8B8A8Unorm,
+            extent,
+            mipLevels, 1,
+            vk::SampleCountFlagBits::e1,
+            vk::ImageTiling::eOptimal,
+            vk::ImageUsageFlagBits::eTransferDst /* staging dst */
+                | usage
+                | vk::ImageUsageFlagBits::eTransferSrc /* destaging src */,
+        });
+    }
+
+    /**
+     * Get a staging buffer filled with \p data.
+     */
+    [[nodiscard]] auto acquireStagingBuffer(
+        std::span<const std::byte> data
+    ) -> const vku::MappedBuffer & {
+        const vku::MappedBuffer &buffer = resourcePool.acquireBuffer(data.size_bytes(), vk::BufferUsageFlagBits::eTransferSrc /* staging src */);
+        std::ranges::copy(data, static_cast<std::byte*>(buffer.data));
+        return buffer;
+    }
+
+    [[nodiscard]] auto acquireDestagingBuffer(
+        vk::DeviceSize size
+    ) -> const vku::MappedBuffer & {
+        return resourcePool.acquireBuffer(size, vk::BufferUsageFlagBits::eTransferDst /* destaging dst */);
+    }
+
+    /**
+     * Get the pipeline for \p mipImageCount mip images from \p computers, or create it with \p args if not exists.
+     */
+    template <typename Computer>
+    [[nodiscard]] auto getComputer(
+        std::map<std::uint32_t, Computer> &computers,
+        std::uint32_t mipImageCount,
+        auto &&...args
+    ) const -> const Computer & {
+        std::scoped_lock lock { computersMutex };
+        return computers.try_emplace(mipImageCount, device, mipImageCount, FWD(args)...).first->second;
+    }
+
+    /**
+     * Execute the commands recorded by \p f, and print its elapsed time measured by the query pool of \p context with
+     * \p label.
+     */
+    auto executeTimedCommand(
+        const RecordingContext &context,
+        std::string_view label,
+        std::invocable<vk::CommandBuffer> auto &&f
+    ) const -> void {
+        const vk::raii::QueryPool &queryPool = context.queryPool;
+        const auto recordCommands = [&](vk::CommandBuffer commandBuffer) {
+            commandBuffer.resetQueryPool(*queryPool, 0, 2);
+            commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eNone, *queryPool, 0);
+
+            f(commandBuffer);
+
+            commandBuffer.writeTimestamp2(vk::PipelineStageFlagBits2::eAllCommands, *queryPool, 1);
         };
 
-        // 1. Blit-based mipmap generation.
-        {
-            const vku::Image &targetImage = get<0>(baseImages);
+        if (context.batcher) {
+            // Record in the calling thread, and let the submitting thread execute it with the other threads' ones.
+            const vk::CommandBuffer commandBuffer = (*device).allocateCommandBuffers(vk::CommandBufferAllocateInfo {
+                context.commandPool,
+                vk::CommandBufferLevel::ePrimary,
+                1,
+            })[0];
+            commandBuffer.begin(vk::CommandBufferBeginInfo { vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+            recordCommands(commandBuffer);
+            commandBuffer.end();
 
-            vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
-                commandBuffer.resetQueryPool(*queryPool, 0, 2);
-                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, 0);
-
-                for (auto [srcLevel, dstLevel] : std::views::iota(0U, targetImage.mipLevels) | ranges::views::pairwise) {
-                    commandBuffer.pipelineBarrier(
-                        srcLevel == 0U ? vk::PipelineStageFlagBits::eTopOfPipe : vk::PipelineStageFlagBits::eTransfer, vk::PipelineStageFlagBits::eTransfer,
-                        {}, {}, {},
-                        std::array {
-                            vk::ImageMemoryBarrier {
-                                srcLevel == 0U ? vk::AccessFlagBits::eNone : vk::AccessFlagBits::eTransferWrite, vk::AccessFlagBits::eTransferRead,
-                                vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eTransferSrcOptimal,
-                                vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
-                                targetImage,
-                                { vk::ImageAspectFlagBits::eColor, srcLevel, 1, 0, 1 }
-                            },
-                            vk::ImageMemoryBarrier {
-                                {}, vk::AccessFlagBits::eTransferWrite,
-                                {}, vk::ImageLayout::eTransferDstOptimal,
-                                vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
-                                targetImage,
-                                { vk::ImageAspectFlagBits::eColor, dstLevel, 1, 0, 1 }
-                            },
-                        });
-
-                    commandBuffer.blitImage(
-                        targetImage, vk::ImageLayout::eTransferSrcOptimal,
-                        targetImage, vk::ImageLayout::eTransferDstOptimal,
-                        vk::ImageBlit {
-                            { vk::ImageAspectFlagBits::eColor, srcLevel, 0, 1 },
-                            { vk::Offset3D{}, vk::Offset3D { vku::convertOffset2D(targetImage.mipExtent(srcLevel)), 1 } },
-                            { vk::ImageAspectFlagBits::eColor, dstLevel, 0, 1 },
-                            { vk::Offset3D{}, vk::Offset3D { vku::convertOffset2D(targetImage.mipExtent(dstLevel)), 1 } },
-                        },
-                        vk::Filter::eLinear);
-                }
-
-                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
-            });
+            context.batcher->submitAndWait(commandBuffer);
+            (*device).freeCommandBuffers(context.commandPool, commandBuffer);
+        }
+        else {
+            vku::executeSingleCommand(*device, context.commandPool, queues.computeGraphics, recordCommands);
             queues.computeGraphics.waitIdle();
-            printElapsedTime("Blit based mipmap generation");
         }
 
-        // 2. Compute shader mipmap generation with per-level barriers.
-        {
-            const vku::Image &targetImage = get<1>(baseImages);
+        // Print the elapsed time.
+        const auto [result, timestamps] = queryPool.getResults<std::uint64_t>(
+            0, 2, 2 * sizeof(std::uint64_t), sizeof(std::uint64_t), vk::QueryResultFlagBits::e64);
+        if (result == vk::Result::eSuccess) {
+            // Command buffers in the same batch may be executed concurrently, therefore their GPU time includes the
+            // contention and is not comparable with the serial execution.
+            std::println("{}{}: {} us", label, context.batcher ? " (overlapped with other threads)" : "", (timestamps[1] - timestamps[0]) * physicalDevice.getProperties().limits.timestampPeriod / 1e3f);
+        }
+        else {
+            std::println(std::cerr, "Failed to get timestamp query: {}", to_string(result));
+        }
+    }
 
-            // Prepare the pipeline and descriptor set.
-            const MipmapComputer mipmapComputer { device, targetImage.mipLevels };
-            const MipmapComputer::DescriptorSets descriptorSets { *device, *descriptorPool, mipmapComputer.descriptorSetLayouts };
+    /**
+     * Generate mipmaps of \p targetImage, whose base level is in <tt>VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL</tt> layout.
+     * After the generation, every levels are in <tt>VK_IMAGE_LAYOUT_GENERAL</tt> layout.
+     *
+     * If \p regionUpdate is given, after the full generation, its staging buffer is copied into the rect of the base
+     * level and only the footprint of the rect is regenerated on every mip level.
+     */
+    auto generateMipmaps(
+        Strategy strategy,
+        const vku::Image &targetImage,
+        const RecordingContext &context,
+        const std::optional<RegionUpdate> &regionUpdate = std::nullopt
+    ) -> void {
+        const vk::Extent2D baseImageExtent { targetImage.extent.width, targetImage.extent.height };
+        const bool isVolume = targetImage.extent.depth > 1U;
 
-            const std::vector imageMipViews
-                = std::views::iota(0U, targetImage.mipLevels)
+        // Image views and descriptor sets are only used by compute strategies.
+        const auto createImageMipViews = [&](vk::ImageViewType viewType) {
+            return std::views::iota(0U, targetImage.mipLevels)
                 | std::views::transform([&](std::uint32_t mipLevel) {
                     return vk::raii::ImageView { device, vk::ImageViewCreateInfo {
                         {},
                         targetImage,
-                        vk::ImageViewType::e2D,
+                        viewType,
                         targetImage.format,
                         {},
                         { vk::ImageAspectFlagBits::eColor, mipLevel, 1, 0, 1 },
                     } };
                 })
                 | std::ranges::to<std::vector>();
+        };
+        // Base level is written by the staging, and the other levels are fully overwritten. After the command, every
+        // levels are in VK_IMAGE_LAYOUT_GENERAL layout.
+        const auto recordGeneralLayoutTransition = [&](vk::CommandBuffer commandBuffer, vk::PipelineStageFlags2 dstStageMask, vk::AccessFlags2 dstReadAccessMask, vk::AccessFlags2 dstWriteAccessMask) {
+            const std::array imageMemoryBarriers {
+                vk::ImageMemoryBarrier2 {
+                    vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                    dstStageMask, dstReadAccessMask,
+                    vk::ImageLayout::eTransferDstOptimal, vk::ImageLayout::eGeneral,
+                    vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                    targetImage,
+                    { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
+                },
+                vk::ImageMemoryBarrier2 {
+                    vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                    dstStageMask, dstReadAccessMask | dstWriteAccessMask,
+                    vk::ImageLayout::eUndefined, vk::ImageLayout::eGeneral,
+                    vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                    targetImage,
+                    { vk::ImageAspectFlagBits::eColor, 1, vk::RemainingMipLevels, 0, 1 },
+                },
+            };
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarriers });
+        };
+        // Copy regionUpdate's staging buffer into the base level in VK_IMAGE_LAYOUT_GENERAL layout, after the reads at
+        // srcStageMask are done, and make it visible to the reads at dstStageMask.
+        const auto recordRegionUpload = [&](vk::CommandBuffer commandBuffer, vk::PipelineStageFlags2 srcStageMask, vk::PipelineStageFlags2 dstStageMask, vk::AccessFlags2 dstAccessMask) {
+            // Write-after-read hazard only needs an execution dependency.
+            const vk::MemoryBarrier2 preCopyBarrier {
+                srcStageMask, vk::AccessFlagBits2::eNone,
+                vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+            };
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, preCopyBarrier });
 
-            // Update descriptor sets.
-            device.updateDescriptorSets(
-                descriptorSets.getDescriptorWrites0(imageMipViews | ranges::views::deref).get(),
-                {});
+            commandBuffer.copyBufferToImage(
+                regionUpdate->stagingBuffer,
+                targetImage, vk::ImageLayout::eGeneral,
+                vk::BufferImageCopy {
+                    0, 0, 0,
+                    { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+                    vk::Offset3D { regionUpdate->rect.offset, 0 },
+                    vk::Extent3D { regionUpdate->rect.extent, 1 },
+                });
 
-            vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
-                commandBuffer.resetQueryPool(*queryPool, 0, 2);
-                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, 0);
-
-               commandBuffer.pipelineBarrier(
-                   vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader,
-                   {}, {}, {},
-                   vk::ImageMemoryBarrier {
-                       {}, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
-                       {}, vk::ImageLayout::eGeneral,
-                       vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
-                       targetImage,
-                       vku::fullSubresourceRange(),
-                   });
-
-                mipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels);
-
-                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
-            });
-            queues.computeGraphics.waitIdle();
-            printElapsedTime("Compute shader mipmap generation with per-level barriers");
-        }
+            const vk::MemoryBarrier2 postCopyBarrier {
+                vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                dstStageMask, dstAccessMask,
+            };
+            commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, postCopyBarrier });
+        };
 
-        // 3. Compute shader mipmap generation with subgroups.
-        {
-            const vku::Image &targetImage = get<2>(baseImages);
-
-            // Get subgroup size from physical device properties.
-            const std::uint32_t subgroupSize
-                = physicalDevice.getProperties2<
-                    vk::PhysicalDeviceProperties2,
-                    vk::PhysicalDeviceSubgroupProperties>()
-                .get<vk::PhysicalDeviceSubgroupProperties>()
-                .subgroupSize;
-
-            // Prepare the pipeline and descriptor set.
-            const SubgroupMipmapComputer subgroupMipmapComputer { device, targetImage.mipLevels, subgroupSize };
-            const SubgroupMipmapComputer::DescriptorSets descriptorSets { *device, *descriptorPool, subgroupMipmapComputer.descriptorSetLayouts };
-
-            const std::vector imageMipViews
-                = std::views::iota(0U, targetImage.mipLevels)
-                | std::views::transform([&](std::uint32_t mipLevel) {
-                    return vk::raii::ImageView { device, vk::ImageViewCreateInfo {
-                        {},
-                        targetImage,
-                        vk::ImageViewType::e2D,
-                        targetImage.format,
-                        {},
-                        { vk::ImageAspectFlagBits::eColor, mipLevel, 1, 0, 1 },
-                    } };
-                })
-                | std::ranges::to<std::vector>();
+        const std::string regionUpdateLabel = regionUpdate
+            ? std::format("{} (dirty region {}x{})", getLabel(strategy), regionUpdate->rect.extent.width, regionUpdate->rect.extent.height)
+            : std::string{};
+
+        // Common routine for (Subgroup)MipmapComputer and (Subgroup)VolumeMipmapComputer. Dirty region is only supported by
+        // the 2D ones, which take vk::Extent2D.
+        const auto computeMipmaps = [&]<typename Computer, typename Extent>(const Computer &computer, const Extent &computeExtent) {
+            // Prepare the descriptor set.
+            const typename Computer::DescriptorSets descriptorSets { *device, context.descriptorPool, computer.descriptorSetLayouts };
 
             // Update descriptor sets.
+            // SubgroupMipmapComputer takes 2D array views.
+            const std::vector imageMipViews = createImageMipViews(
+                isVolume ? vk::ImageViewType::e3D
+                : std::same_as<Computer, SubgroupMipmapComputer> ? vk::ImageViewType::e2DArray
+                : vk::ImageViewType::e2D);
             device.updateDescriptorSets(
                 descriptorSets.getDescriptorWrites0(imageMipViews | ranges::views::deref).get(),
                 {});
 
-            vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
-                commandBuffer.resetQueryPool(*queryPool, 0, 2);
-                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eTopOfPipe, *queryPool, 0);
-
-                commandBuffer.pipelineBarrier(
-                    vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eComputeShader,
-                    {}, {}, {},
-                    vk::ImageMemoryBarrier {
-                        {}, vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite,
-                        {}, vk::ImageLayout::eGeneral,
-                        vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
-                        targetImage,
-                        vku::fullSubresourceRange(),
+            executeTimedCommand(context, getLabel(strategy), [&](vk::CommandBuffer commandBuffer) {
+                recordGeneralLayoutTransition(
+                    commandBuffer, vk::PipelineStageFlagBits2::eComputeShader,
+                    vk::AccessFlagBits2::eShaderStorageRead, vk::AccessFlagBits2::eShaderStorageWrite);
+                computer.compute(commandBuffer, descriptorSets, computeExtent, targetImage.mipLevels);
+            });
+
+            if constexpr (std::same_as<Extent, vk::Extent2D>) {
+                if (regionUpdate) {
+                    executeTimedCommand(context, regionUpdateLabel, [&](vk::CommandBuffer commandBuffer) {
+                        recordRegionUpload(
+                            commandBuffer, vk::PipelineStageFlagBits2::eComputeShader,
+                            vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead);
+                        computer.compute(commandBuffer, descriptorSets, computeExtent, targetImage.mipLevels, regionUpdate->rect);
                     });
+                }
+            }
+        };
 
-                subgroupMipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels);
+        switch (strategy) {
+            case Strategy::Blit: {
+                executeTimedCommand(context, getLabel(strategy), [&](vk::CommandBuffer commandBuffer) {
+                    recordGeneralLayoutTransition(
+                        commandBuffer, vk::PipelineStageFlagBits2::eBlit,
+                        vk::AccessFlagBits2::eTransferRead, vk::AccessFlagBits2::eTransferWrite);
+                    recordBlitChain(commandBuffer, targetImage, vk::Rect2D { {}, baseImageExtent });
+                });
 
-                commandBuffer.writeTimestamp(vk::PipelineStageFlagBits::eBottomOfPipe, *queryPool, 1);
-            });
-            queues.computeGraphics.waitIdle();
-            printElapsedTime("Compute shader mipmap generation with subgroup operation");
+                if (regionUpdate) {
+                    executeTimedCommand(context, regionUpdateLabel, [&](vk::CommandBuffer commandBuffer) {
+                        recordRegionUpload(
+                            commandBuffer, vk::PipelineStageFlagBits2::eBlit,
+                            vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead);
+                        recordBlitChain(commandBuffer, targetImage, regionUpdate->rect);
+                    });
+                }
+                break;
+            }
+            case Strategy::ComputePerLevelBarriers: {
+                if (isVolume) {
+                    computeMipmaps(getComputer(volumeMipmapComputers, targetImage.mipLevels), targetImage.extent);
+                }
+                else {
+                    computeMipmaps(getComputer(mipmapComputers, targetImage.mipLevels), baseImageExtent);
+                }
+                break;
+            }
+            case Strategy::ComputeSubgroup: case Strategy::ComputeSubgroupFp16:
+            case Strategy::ComputeSubgroupClustered: case Strategy::ComputeSubgroupQuad: {
+                // Get subgroup size from physical device properties.
+                const std::uint32_t subgroupSize
+                    = physicalDevice.getProperties2<
+                        vk::PhysicalDeviceProperties2,
+                        vk::PhysicalDeviceSubgroupProperties>()
+                    .get<vk::PhysicalDeviceSubgroupProperties>()
+                    .subgroupSize;
+
+                // Kernel variants fall back to the shuffle kernel for volume, or if the device does not support them.
+                if (isVolume) {
+                    computeMipmaps(getComputer(subgroupVolumeMipmapComputers, targetImage.mipLevels, subgroupSize), targetImage.extent);
+                }
+                else {
+                    const SubgroupMipmapComputer::Variant variant
+                        = isSupported(getSubgroupMipmapVariant(strategy)) ? getSubgroupMipmapVariant(strategy) : SubgroupMipmapComputer::Variant::Shuffle;
+                    computeMipmaps(getComputer(subgroupMipmapComputers[std::to_underlying(variant)], targetImage.mipLevels, subgroupSize, variant), baseImageExtent);
+                }
+                break;
+            }
         }
+    }
 
-        // Create host buffers for destaging.
-        const vk::Extent2D destagingImageExtent { baseImageExtent.width * 3U / 2U, baseImageExtent.height };
-        const std::array destagingBuffers
-#pragma clang diagnostic push
-#pragma clang diagnostic ignored "-Wunused-value"
-            = ARRAY_OF(3, vku::MappedBuffer { vku::AllocatedBuffer { allocator, vk::BufferCreateInfo {
-                {},
-                blockSize(vk::Format::eR8G8B8A8Unorm) * destagingImageExtent.width * destagingImageExtent.height,
-                vk::BufferUsageFlagBits::eTransferDst /* destaging dst */,
-            }, vma::AllocationCreateInfo {
-                vma::AllocationCreateFlagBits::eHostAccessRandom | vma::AllocationCreateFlagBits::eMapped,
-                vma::MemoryUsage::eAuto,
-            } } });
-#pragma clang diagnostic pop
+    /**
+     * Check if the device supports the subgroup mipmap kernel \p variant.
+     */
+    [[nodiscard]] auto isSupported(
+        SubgroupMipmapComputer::Variant variant
+    ) const -> bool {
+        const vk::SubgroupFeatureFlags supportedOperations
+            = physicalDevice.getProperties2<
+                vk::PhysicalDeviceProperties2,
+                vk::PhysicalDeviceSubgroupProperties>()
+            .get<vk::PhysicalDeviceSubgroupProperties>()
+            .supportedOperations;
+        switch (variant) {
+            case SubgroupMipmapComputer::Variant::Shuffle: return true;
+            case SubgroupMipmapComputer::Variant::ShuffleFp16: return float16Supported;
+            case SubgroupMipmapComputer::Variant::Clustered: return vku::contains(supportedOperations, vk::SubgroupFeatureFlagBits::eClustered);
+            case SubgroupMipmapComputer::Variant::Quad: return vku::contains(supportedOperations, vk::SubgroupFeatureFlagBits::eQuad);
+        }
+        std::unreachable();
+    }
 
-        // Copy from baseImages[0..3] to destagingBuffers[0..3].
-        vku::executeSingleCommand(*device, *computeGraphicsCommandPool, queues.computeGraphics, [&](vk::CommandBuffer commandBuffer) {
-            commandBuffer.pipelineBarrier(
-                vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
-                {}, {}, {},
-                std::apply([](const auto &...images) {
-                    return std::array {
-                        vk::ImageMemoryBarrier {
-                            {}, vk::AccessFlagBits::eTransferRead,
-                            {}, vk::ImageLayout::eTransferSrcOptimal,
-                            vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
-                            images,
-                            vku::fullSubresourceRange(),
-                        }...
-                    };
-                }, baseImages));
+    /**
+     * Generate mipmaps of each \p targetImages with the corresponding \p strategies in \p threadCount threads, which own
+     * their command pool, descriptor pool and query pool. The command buffers recorded by the threads are submitted by
+     * the calling thread, a single <tt>vkQueueSubmit</tt> per round.
+     */
+    auto generateMipmapsParallel(
+        std::span<const Strategy> strategies,
+        std::span<const vku::Image> targetImages,
+        const std::optional<RegionUpdate> &regionUpdate,
+        std::uint32_t threadCount
+    ) -> void {
+        CommandBatcher batcher { queues.computeGraphics, threadCount };
+        std::vector<std::exception_ptr> exceptions(threadCount);
+        {
+            std::vector<std::jthread> threads;
+            for (std::uint32_t threadIndex : std::views::iota(0U, threadCount)) {
+                threads.emplace_back([&, threadIndex] {
+                    try {
+                        const vk::raii::CommandPool threadCommandPool = createCommandPool(queueFamilyIndices.computeGraphics);
+                        // Strategies are distributed in round-robin manner, and each of them allocates a descriptor set.
+                        const std::uint32_t threadStrategyCount = static_cast<std::uint32_t>((strategies.size() - threadIndex + threadCount - 1) / threadCount);
+                        const vk::raii::DescriptorPool threadDescriptorPool = createDescriptorPool(threadStrategyCount, targetImages.front().mipLevels);
+                        const vk::raii::QueryPool threadQueryPool = createQueryPool();
+                        const RecordingContext context { *threadCommandPool, *threadDescriptorPool, threadQueryPool, &batcher };
 
-            const std::vector copyRegions
-                = std::views::iota(0U, imageMipLevels)
-                | std::views::transform([&, bufferOffset = 0U](std::uint32_t mipLevel) mutable {
-                    if (mipLevel == 1U) {
-                        bufferOffset += blockSize(vk::Format::eR8G8B8A8Unorm) * baseImageExtent.width;
+                        for (std::size_t i = threadIndex; i < strategies.size(); i += threadCount) {
+                            generateMipmaps(strategies[i], targetImages[i], context, regionUpdate);
+                        }
                     }
-                    else if (mipLevel >= 2U) {
-                        bufferOffset += blockSize(vk::Format::eR8G8B8A8Unorm) * destagingImageExtent.width * (destagingImageExtent.height >> (mipLevel - 1U));
+                    catch (...) {
+                        exceptions[threadIndex] = std::current_exception();
                     }
+                    batcher.leave();
+                });
+            }
 
-                    return vk::BufferImageCopy {
-                        bufferOffset, destagingImageExtent.width, destagingImageExtent.height,
-                        { vk::ImageAspectFlagBits::eColor, mipLevel, 0, 1 },
-                        { 0, 0, 0 },
-                        vk::Extent3D { vku::Image::mipExtent(baseImageExtent, mipLevel), 1 },
-                    };
-                })
-                | std::ranges::to<std::vector>();
+            batcher.run();
+        }
 
-            for (const auto &[baseImage, destagingBuffer] : std::views::zip(baseImages, destagingBuffers)) {
-                commandBuffer.copyImageToBuffer(
-                    baseImage, vk::ImageLayout::eTransferSrcOptimal,
-                    destagingBuffer,
-                    copyRegions);
+        for (const std::exception_ptr &exception : exceptions) {
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+        }
+    }
+
+    /**
+     * Record blit commands that generate the mip chain of \p image within the footprint of \p dirtyRect. If \p image is
+     * 3D, all depth slices are processed.
+     *
+     * Every levels must be in <tt>VK_IMAGE_LAYOUT_GENERAL</tt> layout, and the base level must be visible to the blit
+     * stage. As the levels are not transitioned, a level only needs a global memory dependency on the previous blit,
+     * instead of the layout transitions of both source and destination levels.
+     */
+    static auto recordBlitChain(
+        vk::CommandBuffer commandBuffer,
+        const vku::Image &image,
+        const vk::Rect2D &dirtyRect
+    ) -> void {
+        // Footprint of dirtyRect in mipLevel, as [min, max) offsets.
+        const auto getFootprint = [&](std::uint32_t mipLevel) {
+            return std::array {
+                vk::Offset3D { dirtyRect.offset.x >> mipLevel, dirtyRect.offset.y >> mipLevel, 0 },
+                vk::Offset3D {
+                    static_cast<std::int32_t>(vku::divCeil(dirtyRect.offset.x + dirtyRect.extent.width, 1U << mipLevel)),
+                    static_cast<std::int32_t>(vku::divCeil(dirtyRect.offset.y + dirtyRect.extent.height, 1U << mipLevel)),
+                    static_cast<std::int32_t>(getMipExtent(image.extent, mipLevel).depth),
+                },
+            };
+        };
+
+        for (auto [srcLevel, dstLevel] : std::views::iota(0U, image.mipLevels) | ranges::views::pairwise) {
+            if (srcLevel != 0U) {
+                constexpr vk::MemoryBarrier2 memoryBarrier {
+                    vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferWrite,
+                    vk::PipelineStageFlagBits2::eBlit, vk::AccessFlagBits2::eTransferRead,
+                };
+                commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, memoryBarrier });
             }
-        });
-        queues.computeGraphics.waitIdle();
 
-        constexpr std::array filenames { "blit.png", "compute_per_level_barriers.png", "compute_subgroup.png" };
-        for (const auto &[destagingBuffer, filename] : std::views::zip(destagingBuffers, filenames)) {
-            stbi_write_png((outputDir / filename).string().c_str(),
-                destagingImageExtent.width, destagingImageExtent.height, 4,
-                destagingBuffer.data, blockSize(vk::Format::eR8G8B8A8Unorm) * destagingImageExtent.width);
+            // Source region is twice of the destination footprint, clamped by the source extent (for non-square image,
+            // one of the dimension is clamped to 1).
+            const auto [dstMin, dstMax] = getFootprint(dstLevel);
+            const vk::Extent3D srcExtent = getMipExtent(image.extent, srcLevel);
+            const vk::Offset3D srcMaxOffset {
+                static_cast<std::int32_t>(srcExtent.width),
+                static_cast<std::int32_t>(srcExtent.height),
+                static_cast<std::int32_t>(srcExtent.depth),
+            };
+            commandBuffer.blitImage(
+                image, vk::ImageLayout::eGeneral,
+                image, vk::ImageLayout::eGeneral,
+                vk::ImageBlit {
+                    { vk::ImageAspectFlagBits::eColor, srcLevel, 0, 1 },
+                    {
+                        vk::Offset3D { std::min(2 * dstMin.x, srcMaxOffset.x - 1), std::min(2 * dstMin.y, srcMaxOffset.y - 1), 0 },
+                        vk::Offset3D { std::min(2 * dstMax.x, srcMaxOffset.x), std::min(2 * dstMax.y, srcMaxOffset.y), std::min(2 * dstMax.z, srcMaxOffset.z) },
+                    },
+                    { vk::ImageAspectFlagBits::eColor, dstLevel, 0, 1 },
+                    { dstMin, dstMax },
+                },
+                vk::Filter::eLinear);
         }
     }
 
-private:
-    vku::Allocator allocator = createAllocator();
-    vk::raii::DescriptorPool descriptorPool = createDescriptorPool();
-    vk::raii::CommandPool computeGraphicsCommandPool = createCommandPool(queueFamilyIndices.computeGraphics);
+    /**
+     * Load image at \p path. If \p path is <tt>shm:<name></tt>, the encoded image file is read from the POSIX shared
+     * memory object <tt><name></tt> (server mode only), without copying it into a file.
+     */
+    template <typename T>
+    [[nodiscard]] static auto loadImageData(
+        const std::filesystem::path &path,
+        int desiredChannels
+    ) -> ImageData<T> {
+        const MappedFile file { path };
+        return ImageData<T> { file.getSpan(), desiredChannels };
+    }
+
+    /**
+     * Load the input images at \p paths in parallel, by splitting them into a chunk per hardware thread.
+     */
+    [[nodiscard]] static auto loadInputImages(
+        std::span<const std::filesystem::path> paths
+    ) -> std::vector<InputImage> {
+        const std::size_t threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+        const std::size_t chunkSize = (paths.size() + threadCount - 1) / threadCount;
+        std::vector<std::future<std::vector<InputImage>>> chunkFutures;
+        for (std::size_t offset = 0; offset < paths.size(); offset += chunkSize) {
+            chunkFutures.push_back(std::async(std::launch::async, [chunk = paths.subspan(offset, std::min(chunkSize, paths.size() - offset))] {
+                return chunk
+                    | std::views::transform([](const std::filesystem::path &path) { return InputImage { path }; })
+                    | std::ranges::to<std::vector>();
+            }));
+        }
+
+        std::vector<InputImage> inputImages;
+        inputImages.reserve(paths.size());
+        for (std::future<std::vector<InputImage>> &chunkFuture : chunkFutures) {
+            std::ranges::move(chunkFuture.get(), std::back_inserter(inputImages));
+        }
+        return inputImages;
+    }
+
+    /**
+     * Get the available memory size of the device, using <tt>VK_EXT_memory_budget</tt>.
+     * @return Available memory budget, or <tt>std::nullopt</tt> if the extension is not supported.
+     */
+    [[nodiscard]] auto getMemoryBudget() const -> std::optional<MemoryBudget> {
+        if (!std::ranges::any_of(physicalDevice.enumerateDeviceExtensionProperties(), [](const vk::ExtensionProperties &properties) {
+            return std::string_view { properties.extensionName.data() } == VK_EXT_MEMORY_BUDGET_EXTENSION_NAME;
+        })) {
+            return std::nullopt;
+        }
+
+        const vk::StructureChain memoryProperties2
+            = physicalDevice.getMemoryProperties2<vk::PhysicalDeviceMemoryProperties2, vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+        const vk::PhysicalDeviceMemoryProperties &memoryProperties = memoryProperties2.get<vk::PhysicalDeviceMemoryProperties2>().memoryProperties;
+        const auto &memoryBudgetProperties = memoryProperties2.get<vk::PhysicalDeviceMemoryBudgetPropertiesEXT>();
+
+        MemoryBudget memoryBudget { 0, 0 };
+        for (std::uint32_t heapIndex : std::views::iota(0U, memoryProperties.memoryHeapCount)) {
+            // Usage may exceed the budget if other processes allocate the memory.
+            const vk::DeviceSize budget = memoryBudgetProperties.heapBudget[heapIndex];
+            const vk::DeviceSize availableSize = budget - std::min(memoryBudgetProperties.heapUsage[heapIndex], budget);
+            if (memoryProperties.memoryHeaps[heapIndex].flags & vk::MemoryHeapFlagBits::eDeviceLocal) {
+                memoryBudget.deviceLocal = std::max(memoryBudget.deviceLocal, availableSize);
+            }
+            memoryBudget.total += availableSize;
+        }
+        return memoryBudget;
+    }
+
+    /**
+     * Check if fp16 arithmetic (<tt>shaderFloat16</tt>) and subgroup operations on it (<tt>shaderSubgroupExtendedTypes</tt>)
+     * are supported. As the device features are decided before the physical device is selected, they are only enabled
+     * when every physical devices support them.
+     */
+    [[nodiscard]] auto isFloat16Supported() const -> bool {
+        return std::ranges::all_of(instance.enumeratePhysicalDevices(), [](const vk::raii::PhysicalDevice &physicalDevice) {
+            const vk::StructureChain features2
+                = physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceShaderFloat16Int8Features, vk::PhysicalDeviceShaderSubgroupExtendedTypesFeatures>();
+            return features2.get<vk::PhysicalDeviceShaderFloat16Int8Features>().shaderFloat16
+                && features2.get<vk::PhysicalDeviceShaderSubgroupExtendedTypesFeatures>().shaderSubgroupExtendedTypes;
+        });
+    }
 
     [[nodiscard]] auto createGpu() const -> Gpu {
-        return Gpu { instance, Gpu::Config<std::tuple<vk::PhysicalDeviceHostQueryResetFeatures, vk::PhysicalDeviceDescriptorIndexingFeatures>> {
+        const vk::Bool32 float16 = isFloat16Supported();
+        return Gpu { instance, Gpu::Config<std::tuple<vk::PhysicalDeviceHostQueryResetFeatures, vk::PhysicalDeviceDescriptorIndexingFeatures, vk::PhysicalDeviceSynchronization2Features, vk::PhysicalDeviceShaderFloat16Int8Features, vk::PhysicalDeviceShaderSubgroupExtendedTypesFeatures>> {
+            // rg32f storage image is used by min-max Hi-Z pyramid.
+            .physicalDeviceFeatures = vk::PhysicalDeviceFeatures{}
+                .setShaderStorageImageExtendedFormats(vk::True),
             .physicalDeviceRater = [](vk::PhysicalDevice physicalDevice) {
+                if (!physicalDevice.getFeatures().shaderStorageImageExtendedFormats) {
+                    // Extended storage image formats not supported.
+                    return 0U;
+                }
+
+                if (physicalDevice.getProperties().apiVersion < vk::makeApiVersion(0, 1, 3, 0)
+                    || !physicalDevice.getFeatures2<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceSynchronization2Features>()
+                        .get<vk::PhysicalDeviceSynchronization2Features>().synchronization2) {
+                    // Synchronization2 not supported.
+                    return 0U;
+                }
+
                 if (const vk::PhysicalDeviceLimits limits = physicalDevice.getProperties().limits;
                     limits.timestampPeriod == 0.f || !limits.timestampComputeAndGraphics) {
                     // Timestamp query not supported.
@@ -411,6 +2111,10 @@ private:
                 vk::PhysicalDeviceDescriptorIndexingFeatures{}
                     .setDescriptorBindingStorageImageUpdateAfterBind(vk::True)
                     .setRuntimeDescriptorArray(vk::True),
+                vk::PhysicalDeviceSynchronization2Features { vk::True },
+                vk::PhysicalDeviceShaderFloat16Int8Features{}
+                    .setShaderFloat16(float16),
+                vk::PhysicalDeviceShaderSubgroupExtendedTypesFeatures { float16 },
             },
         } };
     }
@@ -421,21 +2125,37 @@ private:
             *physicalDevice, *device,
             {}, {}, {}, {}, {},
             *instance,
-            vk::makeApiVersion(0, 1, 2, 0),
+            vk::makeApiVersion(0, 1, 3, 0),
         } };
     }
 
-    [[nodiscard]] auto createDescriptorPool() const -> vk::raii::DescriptorPool {
-        constexpr std::array poolSizes {
-            vk::DescriptorPoolSize { vk::DescriptorType::eStorageImage, 32 },
+    /**
+     * Create descriptor pool that can allocate \p maxSets descriptor sets, each of them has at most \p mipImageCount mip
+     * images (and a sampled image for SubgroupHiZComputer).
+     */
+    [[nodiscard]] auto createDescriptorPool(
+        std::uint32_t maxSets,
+        std::uint32_t mipImageCount
+    ) const -> vk::raii::DescriptorPool {
+        const std::array poolSizes {
+            vk::DescriptorPoolSize { vk::DescriptorType::eStorageImage, mipImageCount * maxSets },
+            vk::DescriptorPoolSize { vk::DescriptorType::eSampledImage, maxSets },
         };
         return { device, vk::DescriptorPoolCreateInfo {
             vk::DescriptorPoolCreateFlagBits::eUpdateAfterBind,
-            2,
+            maxSets,
             poolSizes,
         } };
     }
 
+    [[nodiscard]] auto createQueryPool() const -> vk::raii::QueryPool {
+        return { device, vk::QueryPoolCreateInfo {
+            {},
+            vk::QueryType::eTimestamp,
+            2,
+        } };
+    }
+
     [[nodiscard]] auto createCommandPool(
         std::uint32_t queueFamilyIndex
     ) const -> vk::raii::CommandPool {
@@ -449,16 +2169,182 @@ private:
         return Instance { vk::ApplicationInfo {
             "mipmap", 0,
             {}, 0,
-            vk::makeApiVersion(0, 1, 2, 0),
+            vk::makeApiVersion(0, 1, 3, 0),
         } };
     }
+
+    [[nodiscard]] static auto getMipExtent(
+        const vk::Extent3D &baseImageExtent,
+        std::uint32_t mipLevel
+    ) noexcept -> vk::Extent3D {
+        return {
+            std::max(baseImageExtent.width >> mipLevel, 1U),
+            std::max(baseImageExtent.height >> mipLevel, 1U),
+            std::max(baseImageExtent.depth >> mipLevel, 1U),
+        };
+    }
+
+    [[nodiscard]] static auto getMipChainSize(
+        const vk::Extent3D &baseImageExtent,
+        std::uint32_t mipLevels
+    ) noexcept -> vk::DeviceSize {
+        vk::DeviceSize size = 0;
+        for (std::uint32_t mipLevel : std::views::iota(0U, mipLevels)) {
+            const vk::Extent3D mipExtent = getMipExtent(baseImageExtent, mipLevel);
+            size += blockSize(vk::Format::eR8G8B8A8Unorm) * mipExtent.width * mipExtent.height * mipExtent.depth;
+        }
+        return size;
+    }
+
+    static auto recordStagingCommands(
+        vk::CommandBuffer commandBuffer,
+        vk::Buffer stagingBuffer,
+        std::span<const vku::Image> baseImages
+    ) -> void {
+        const std::vector imageMemoryBarriers
+            = baseImages
+            | std::views::transform([](vk::Image image) {
+                return vk::ImageMemoryBarrier2 {
+                    vk::PipelineStageFlagBits2::eNone, vk::AccessFlagBits2::eNone,
+                    vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferWrite,
+                    {}, vk::ImageLayout::eTransferDstOptimal,
+                    vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                    image,
+                    { vk::ImageAspectFlagBits::eColor, 0, 1, 0, 1 },
+                };
+            })
+            | std::ranges::to<std::vector>();
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarriers });
+
+        for (const vku::Image &baseImage : baseImages) {
+            commandBuffer.copyBufferToImage(
+                stagingBuffer,
+                baseImage, vk::ImageLayout::eTransferDstOptimal,
+                vk::BufferImageCopy {
+                    0, 0, 0,
+                    { vk::ImageAspectFlagBits::eColor, 0, 0, 1 },
+                    { 0, 0, 0 },
+                    baseImage.extent,
+                });
+        }
+    }
+
+    /**
+     * @param writeScopes Pipeline stage and access that each of \p baseImages is last written with.
+     */
+    static auto recordDestagingCommands(
+        vk::CommandBuffer commandBuffer,
+        std::span<const vku::Image> baseImages,
+        std::span<const WriteScope> writeScopes,
+        std::span<const vk::Buffer> destagingBuffers,
+        std::span<const vk::BufferImageCopy> copyRegions
+    ) -> void {
+        // Every strategies leave the image in VK_IMAGE_LAYOUT_GENERAL layout.
+        const std::vector imageMemoryBarriers
+            = std::views::zip(baseImages, writeScopes)
+            | std::views::transform([](const auto &pair) {
+                const auto &[image, writeScope] = pair;
+                return vk::ImageMemoryBarrier2 {
+                    writeScope.stageMask, writeScope.accessMask,
+                    vk::PipelineStageFlagBits2::eCopy, vk::AccessFlagBits2::eTransferRead,
+                    vk::ImageLayout::eGeneral, vk::ImageLayout::eTransferSrcOptimal,
+                    vk::QueueFamilyIgnored, vk::QueueFamilyIgnored,
+                    image,
+                    vku::fullSubresourceRange(),
+                };
+            })
+            | std::ranges::to<std::vector>();
+        commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, {}, {}, imageMemoryBarriers });
+
+        for (const auto &[baseImage, destagingBuffer] : std::views::zip(baseImages, destagingBuffers)) {
+            commandBuffer.copyImageToBuffer(
+                baseImage, vk::ImageLayout::eTransferSrcOptimal,
+                destagingBuffer,
+                copyRegions);
+        }
+    }
+
+    /**
+     * Get copy regions that place all mip levels into a single atlas, whose width is 1.5x of the base image. Level 0 is
+     * placed at the left, and the remaining levels are stacked from top to bottom at the right.
+     */
+    [[nodiscard]] static auto getAtlasCopyRegions(
+        const vk::Extent2D &baseImageExtent,
+        std::uint32_t mipLevels,
+        const vk::Extent2D &atlasExtent
+    ) -> std::vector<vk::BufferImageCopy> {
+        return std::views::iota(0U, mipLevels)
+            | std::views::transform([&, bufferOffset = vk::DeviceSize { 0 }](std::uint32_t mipLevel) mutable {
+                if (mipLevel == 1U) {
+                    bufferOffset += blockSize(vk::Format::eR8G8B8A8Unorm) * baseImageExtent.width;
+                }
+                else if (mipLevel >= 2U) {
+                    bufferOffset += blockSize(vk::Format::eR8G8B8A8Unorm) * atlasExtent.width * (atlasExtent.height >> (mipLevel - 1U));
+                }
+
+                return vk::BufferImageCopy {
+                    bufferOffset, atlasExtent.width, atlasExtent.height,
+                    { vk::ImageAspectFlagBits::eColor, mipLevel, 0, 1 },
+                    { 0, 0, 0 },
+                    vk::Extent3D { vku::Image::mipExtent(baseImageExtent, mipLevel), 1 },
+                };
+            })
+            | std::ranges::to<std::vector>();
+    }
+
+    /**
+     * Get copy regions that place mip levels in [\p baseMipLevel, \p baseMipLevel + \p levelCount) back to back
+     * without any padding. Texel size is determined by \p format.
+     */
+    [[nodiscard]] static auto getPackedCopyRegions(
+        const vk::Extent3D &baseImageExtent,
+        std::uint32_t baseMipLevel,
+        std::uint32_t levelCount,
+        vk::Format format = vk::Format::eR8G8B8A8Unorm
+    ) -> std::vector<vk::BufferImageCopy> {
+        return std::views::iota(baseMipLevel, baseMipLevel + levelCount)
+            | std::views::transform([&, bufferOffset = vk::DeviceSize { 0 }](std::uint32_t mipLevel) mutable {
+                const vk::Extent3D mipExtent = getMipExtent(baseImageExtent, mipLevel);
+                const vk::BufferImageCopy copyRegion {
+                    bufferOffset, 0, 0,
+                    { vk::ImageAspectFlagBits::eColor, mipLevel, 0, 1 },
+                    { 0, 0, 0 },
+                    mipExtent,
+                };
+                bufferOffset += blockSize(format) * mipExtent.width * mipExtent.height * mipExtent.depth;
+                return copyRegion;
+            })
+            | std::ranges::to<std::vector>();
+    }
 };
 
 int main(int argc, char **argv) {
-    if (argc != 3) {
-        std::println(std::cerr, "Usage: {} <image-path> <output-dir>", argv[0]);
+    Options options;
+    try {
+        options = Options::parse({ argv + 1, argv + argc });
+    }
+    catch (const std::invalid_argument &e) {
+        std::println(std::cerr, "{}", e.what());
+        std::println(std::cerr, "Usage: {} [--budgeted] [--strategies=<name>[,<name>...]] [--levels=<base>[..[<last>]]] [--dirty-rect=<x>,<y>,<width>,<height>] [--volume] [--threads=<count>] [--hiz=min|max|minmax] <image-path> <output-dir>", argv[0]);
+        std::println(std::cerr, "       {} --packed [--levels=<base>[..[<last>]]] <image-path>... <output-dir>", argv[0]);
+        std::println(std::cerr, "       {} --serve=<socket-path>", argv[0]);
         std::exit(1);
     }
 
-    MainApp{}.run(argv[1], argv[2]);
-}
\ No newline at end of file
+    // Decode the input image while the instance, device and pipelines are being created.
+    std::future<InputImage> inputImageFuture;
+    if (!options.serveSocketPath && !options.hizReductionMode && options.packedImagePaths.empty()) {
+        inputImageFuture = std::async(std::launch::async, [&] { return InputImage { options.imagePath }; });
+    }
+
+    MainApp mainApp{};
+    if (options.serveSocketPath) {
+        mainApp.serve(*options.serveSocketPath);
+    }
+    else if (inputImageFuture.valid()) {
+        mainApp.run(options, inputImageFuture.get());
+    }
+    else {
+        mainApp.run(options);
+    }
+}
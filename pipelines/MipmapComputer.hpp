@@ -27,6 +27,10 @@
  * // Execute compute shader.
  * // Image layout must be VK_IMAGE_LAYOUT_GENERAL.
  * mipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels); // baseImageExtent = targetImage.extent
+ *
+ * // Or, if only the dirtyRect region of the base level is modified after the previous computation, only its footprint
+ * // on every mip level is updated.
+ * mipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels, dirtyRect);
  * @endcode
  */
 class MipmapComputer {
@@ -65,6 +69,7 @@ public:
 
     struct PushConstant {
         std::uint32_t baseLevel;
+        alignas(8) std::array<std::uint32_t, 2> workgroupOffset;
     };
 
     DescriptorSetLayouts descriptorSetLayouts;
@@ -83,25 +88,39 @@ public:
         const DescriptorSets &descriptorSets,
         const vk::Extent2D &baseImageExtent,
         std::uint32_t mipLevels
+    ) const -> void {
+        compute(commandBuffer, descriptorSets, baseImageExtent, mipLevels, vk::Rect2D { {}, baseImageExtent });
+    }
+
+    auto compute(
+        vk::CommandBuffer commandBuffer,
+        const DescriptorSets &descriptorSets,
+        const vk::Extent2D &baseImageExtent,
+        std::uint32_t mipLevels,
+        const vk::Rect2D &dirtyRect
     ) const -> void {
         commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSets, {});
         for (auto [srcLevel, dstLevel] : std::views::iota(0U, mipLevels) | ranges::views::pairwise) {
             if (srcLevel != 0U) {
-                commandBuffer.pipelineBarrier(
-                    vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-                    {},
-                    vk::MemoryBarrier {
-                        vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead,
-                    },
-                    {}, {});
+                constexpr vk::MemoryBarrier2 memoryBarrier {
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead,
+                };
+                commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, memoryBarrier });
             }
 
-            commandBuffer.pushConstants<PushConstant>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, PushConstant { srcLevel });
-            commandBuffer.dispatch(
-                vku::divCeil(baseImageExtent.width >> dstLevel, 16U),
-                vku::divCeil(baseImageExtent.height >> dstLevel, 16U),
-                1);
+            // Workgroups that cover the footprint of dirtyRect in dstLevel.
+            const std::uint32_t workgroupOffsetX = (static_cast<std::uint32_t>(dirtyRect.offset.x) >> dstLevel) / 16U;
+            const std::uint32_t workgroupOffsetY = (static_cast<std::uint32_t>(dirtyRect.offset.y) >> dstLevel) / 16U;
+            const std::uint32_t workgroupEndX = vku::divCeil(vku::divCeil(dirtyRect.offset.x + dirtyRect.extent.width, 1U << dstLevel), 16U);
+            const std::uint32_t workgroupEndY = vku::divCeil(vku::divCeil(dirtyRect.offset.y + dirtyRect.extent.height, 1U << dstLevel), 16U);
+
+            commandBuffer.pushConstants<PushConstant>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, PushConstant {
+                srcLevel,
+                { workgroupOffsetX, workgroupOffsetY },
+            });
+            commandBuffer.dispatch(workgroupEndX - workgroupOffsetX, workgroupEndY - workgroupOffsetY, 1);
         }
     }
 
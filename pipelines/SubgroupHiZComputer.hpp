@@ -0,0 +1,187 @@
+#pragma once
+
+#include <vku/DescriptorSetLayouts.hpp>
+#include <vku/DescriptorSets.hpp>
+#include <vku/pipelines.hpp>
+#include <vku/RefHolder.hpp>
+
+#ifdef NDEBUG
+#include <resources/shaders.hpp>
+#endif
+
+#define FWD(...) static_cast<decltype(__VA_ARGS__) &&>(__VA_ARGS__)
+
+/**
+ * Compute hierarchical-Z (Hi-Z) pyramid of a single channel depth image using subgroup shuffle operation. It has the
+ * same structure with SubgroupMipmapComputer, but texels are reduced by minimum and/or maximum instead of average.
+ *
+ * Pyramid image has half extent of the depth image, and its level i is the reduction of level i + 1 of the full depth
+ * mip chain. Its format must be <tt>VK_FORMAT_R32_SFLOAT</tt> for ReductionMode::Min and ReductionMode::Max, and
+ * <tt>VK_FORMAT_R32G32_SFLOAT</tt> (minimum in R, maximum in G) for ReductionMode::MinMax.
+ *
+ * @code
+ * // Create pipeline and corresponding descriptor sets.
+ * SubgroupHiZComputer subgroupHiZComputer { device, pyramidImage.mipLevels, subgroupSize };
+ * SubgroupHiZComputer::DescriptorSets descriptorSets { device, descriptorPool, subgroupHiZComputer.descriptorSetLayouts };
+ *
+ * // Update descriptorSets with depth image view and pyramid image's mip views.
+ * device.updateDescriptorSets(
+ *     descriptorSets.getDescriptorWrites0(*depthImageView, pyramidMipViews | ranges::views::deref).get(),
+ *     {});
+ *
+ * // Execute compute shader.
+ * // Depth image layout must be VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, and pyramid image layout must be VK_IMAGE_LAYOUT_GENERAL.
+ * subgroupHiZComputer.compute(commandBuffer, descriptorSets, depthImageExtent, pyramidImage.mipLevels + 1, SubgroupHiZComputer::ReductionMode::Min);
+ * @endcode
+ */
+class SubgroupHiZComputer {
+public:
+    enum class ReductionMode : std::uint32_t {
+        Min,
+        Max,
+        MinMax,
+    };
+
+    struct DescriptorSetLayouts : vku::DescriptorSetLayouts<2> {
+        explicit DescriptorSetLayouts(
+            const vk::raii::Device &device,
+            std::uint32_t pyramidImageCount
+        ) : vku::DescriptorSetLayouts<2> { device, LayoutBindings {
+            vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+            vk::DescriptorSetLayoutBinding { 0, vk::DescriptorType::eSampledImage, 1, vk::ShaderStageFlagBits::eCompute },
+            vk::DescriptorSetLayoutBinding { 1, vk::DescriptorType::eStorageImage, pyramidImageCount, vk::ShaderStageFlagBits::eCompute },
+            std::array { vk::DescriptorBindingFlags{}, vku::toFlags(vk::DescriptorBindingFlagBits::eUpdateAfterBind) },
+        } } { }
+    };
+
+    struct DescriptorSets : vku::DescriptorSets<DescriptorSetLayouts> {
+        using vku::DescriptorSets<DescriptorSetLayouts>::DescriptorSets;
+
+        [[nodiscard]] auto getDescriptorWrites0(
+            vk::ImageView depthImageView,
+            auto &&pyramidImageViews
+        ) const noexcept {
+            return vku::RefHolder {
+                [this](const vk::DescriptorImageInfo &depthImageInfo, std::span<const vk::DescriptorImageInfo> pyramidImageInfos) {
+                    return std::array {
+                        getDescriptorWrite<0, 0>().setImageInfo(depthImageInfo),
+                        getDescriptorWrite<0, 1>().setImageInfo(pyramidImageInfos),
+                    };
+                },
+                vk::DescriptorImageInfo { {}, depthImageView, vk::ImageLayout::eShaderReadOnlyOptimal },
+                FWD(pyramidImageViews)
+                    | std::views::transform([](vk::ImageView imageView) {
+                        return vk::DescriptorImageInfo { {}, imageView, vk::ImageLayout::eGeneral };
+                    })
+                    | std::ranges::to<std::vector>(),
+            };
+        }
+    };
+
+    struct PushConstant {
+        std::uint32_t baseLevel;
+        std::uint32_t remainingMipLevels;
+        ReductionMode reductionMode;
+    };
+
+    DescriptorSetLayouts descriptorSetLayouts;
+    vk::raii::PipelineLayout pipelineLayout;
+    vk::raii::Pipeline pipeline;
+
+    explicit SubgroupHiZComputer(
+        const vk::raii::Device &device,
+        std::uint32_t pyramidImageCount,
+        std::uint32_t subgroupSize
+    ) : descriptorSetLayouts { device, pyramidImageCount },
+        pipelineLayout { createPipelineLayout(device) },
+        pipeline { createPipeline(device, subgroupSize) } { }
+
+    /**
+     * @param depthMipLevels Mip levels of the full depth mip chain, i.e. pyramid image's mip levels + 1.
+     */
+    auto compute(
+        vk::CommandBuffer commandBuffer,
+        const DescriptorSets &descriptorSets,
+        const vk::Extent2D &depthImageExtent,
+        std::uint32_t depthMipLevels,
+        ReductionMode reductionMode
+    ) const -> void {
+        // Levels are numbered in the full depth mip chain, i.e. level 0 is the depth image and level i (≥ 1) is the
+        // pyramid image's level i - 1. Chunking is the same as SubgroupMipmapComputer.
+        std::vector<std::vector<std::uint32_t>> indexChunks;
+        for (int endMipLevel = depthMipLevels; endMipLevel > 1; endMipLevel -= 5) {
+            indexChunks.emplace_back(
+                std::views::iota(
+                    static_cast<std::uint32_t>(std::max(1, endMipLevel - 5)),
+                    static_cast<std::uint32_t>(endMipLevel))
+                | std::ranges::to<std::vector>());
+        }
+        std::ranges::reverse(indexChunks);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSets, {});
+        for (const auto &[idx, mipIndices] : indexChunks | ranges::views::enumerate) {
+            if (idx != 0) {
+                constexpr vk::MemoryBarrier2 memoryBarrier {
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead,
+                };
+                commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, memoryBarrier });
+            }
+
+            commandBuffer.pushConstants<PushConstant>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, PushConstant {
+                mipIndices.front() - 1U,
+                static_cast<std::uint32_t>(mipIndices.size()),
+                reductionMode,
+            });
+            commandBuffer.dispatch(
+                vku::divCeil(depthImageExtent.width >> mipIndices.front(), 16U),
+                vku::divCeil(depthImageExtent.height >> mipIndices.front(), 16U),
+                1);
+        }
+    }
+
+private:
+    [[nodiscard]] auto createPipelineLayout(
+        const vk::raii::Device &device
+    ) const -> vk::raii::PipelineLayout {
+        constexpr vk::PushConstantRange pushConstantRange {
+            vk::ShaderStageFlagBits::eCompute,
+            0, sizeof(PushConstant),
+        };
+        return { device, vk::PipelineLayoutCreateInfo {
+            {},
+            descriptorSetLayouts,
+            pushConstantRange,
+        } };
+    }
+
+    [[nodiscard]] auto createPipeline(
+        const vk::raii::Device &device,
+        std::uint32_t subgroupSize
+    ) const -> vk::raii::Pipeline {
+        const auto [_, stages] = vku::createStages(
+            device,
+            vku::Shader { vk::ShaderStageFlagBits::eCompute,
+#ifdef NDEBUG
+                vku::Shader::convert([=] {
+                    switch (subgroupSize) {
+                        case 8U:   return resources::shaders_subgroup_hiz_8_comp();
+                        case 16U:  return resources::shaders_subgroup_hiz_16_comp();
+                        case 32U:  return resources::shaders_subgroup_hiz_32_comp();
+                        case 64U:  return resources::shaders_subgroup_hiz_64_comp();
+                        case 128U: return resources::shaders_subgroup_hiz_128_comp();
+                        default:   throw std::runtime_error { "Subgroup size must be ≥ 8." };
+                    }
+                }()),
+#else
+                vku::Shader::readCode(std::format("shaders/subgroup_hiz_{}.comp.spv", subgroupSize)),
+#endif
+            });
+        return { device, nullptr, vk::ComputePipelineCreateInfo {
+            {},
+            get<0>(stages),
+            *pipelineLayout,
+        } };
+    }
+};
\ No newline at end of file
@@ -14,12 +14,22 @@
 /**
  * Compute image mipmaps using subgroup shuffle operation. More efficient than MipmapComputer.
  *
+ * Reduction kernel is selected by Variant:
+ * - Variant::Shuffle: 2x2 texels are averaged by subgroup shuffle XOR, with the texel mapping for each subgroup size.
+ * - Variant::ShuffleFp16: same as Variant::Shuffle, but colors are averaged and shuffled in half precision, which halves
+ *   the register pressure, shuffle bandwidth and shared memory footprint. It requires <tt>shaderFloat16</tt> and
+ *   <tt>shaderSubgroupExtendedTypes</tt> device features.
+ * - Variant::Clustered: invocations are laid in Morton order, and 2^n x 2^n texels are summed by a single clustered
+ *   add (cluster size 4, 16 and 64). It requires <tt>VK_SUBGROUP_FEATURE_CLUSTERED_BIT</tt>.
+ * - Variant::Quad: invocations are laid in Morton order, and 2x2 texels are summed by the quad swaps. The later levels
+ *   are reduced through shared memory. It requires <tt>VK_SUBGROUP_FEATURE_QUAD_BIT</tt>.
+ *
  * @code
  * // Create pipeline and corresponding descriptor sets.
- * SubgroupMipmapComputer subgroupMipmapComputer { device, mipImageCount, subgroupSize }; // mipImageCount = targetImage.mipLevels
+ * SubgroupMipmapComputer subgroupMipmapComputer { device, mipImageCount, subgroupSize, variant }; // mipImageCount = targetImage.mipLevels
  * SubgroupMipmapComputer::DescriptorSets descriptorSets { device, descriptorPool, subgroupMipmapComputer.descriptorSetLayouts };
  *
- * // Update descriptorSets with image's mip views.
+ * // Update descriptorSets with image's mip views, whose type is VK_IMAGE_VIEW_TYPE_2D_ARRAY.
  * device.updateDescriptorSets(
  *     descriptorSets.getDescriptorWrites0(imageMipViews | ranges::views::deref).get(),
  *     {});
@@ -27,10 +37,25 @@
  * // Execute compute shader.
  * // Image layout must be VK_IMAGE_LAYOUT_GENERAL.
  * subgroupMipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels); // baseImageExtent = targetImage.extent
+ *
+ * // Or, if only the dirtyRect region of the base level is modified after the previous computation, only its footprint
+ * // on every mip level is updated. Footprints are expanded to the 32x32 blocks that each workgroup processes.
+ * subgroupMipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels, dirtyRect);
+ *
+ * // If the image has multiple array layers (e.g. many small images packed into an array image), every layer is
+ * // processed independently by a single dispatch chain.
+ * subgroupMipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels, vk::Rect2D { {}, baseImageExtent }, targetImage.arrayLayers);
  * @endcode
  */
 class SubgroupMipmapComputer {
 public:
+    enum class Variant : std::uint8_t {
+        Shuffle,
+        ShuffleFp16,
+        Clustered,
+        Quad,
+    };
+
     struct DescriptorSetLayouts : vku::DescriptorSetLayouts<1> {
         explicit DescriptorSetLayouts(
             const vk::raii::Device &device,
@@ -66,6 +91,7 @@ public:
     struct PushConstant {
         std::uint32_t baseLevel;
         std::uint32_t remainingMipLevels;
+        std::array<std::uint32_t, 2> workgroupOffset;
     };
 
     DescriptorSetLayouts descriptorSetLayouts;
@@ -75,16 +101,28 @@ public:
     explicit SubgroupMipmapComputer(
         const vk::raii::Device &device,
         std::uint32_t mipImageCount,
-        std::uint32_t subgroupSize
+        std::uint32_t subgroupSize,
+        Variant variant = Variant::Shuffle
     ) : descriptorSetLayouts { device, mipImageCount },
         pipelineLayout { createPipelineLayout(device) },
-        pipeline { createPipeline(device, subgroupSize) } { }
+        pipeline { createPipeline(device, subgroupSize, variant) } { }
 
     auto compute(
         vk::CommandBuffer commandBuffer,
         const DescriptorSets &descriptorSets,
         const vk::Extent2D &baseImageExtent,
         std::uint32_t mipLevels
+    ) const -> void {
+        compute(commandBuffer, descriptorSets, baseImageExtent, mipLevels, vk::Rect2D { {}, baseImageExtent });
+    }
+
+    auto compute(
+        vk::CommandBuffer commandBuffer,
+        const DescriptorSets &descriptorSets,
+        const vk::Extent2D &baseImageExtent,
+        std::uint32_t mipLevels,
+        const vk::Rect2D &dirtyRect,
+        std::uint32_t layerCount = 1
     ) const -> void {
         // Base image size must be greater than or equal to 32. Therefore, the first execution may process less than 5 mip levels.
         // For example, if base extent is 4096x4096 (mipLevels=13),
@@ -116,23 +154,27 @@ public:
         commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSets, {});
         for (const auto &[idx, mipIndices] : indexChunks | ranges::views::enumerate) {
             if (idx != 0) {
-                commandBuffer.pipelineBarrier(
-                    vk::PipelineStageFlagBits::eComputeShader, vk::PipelineStageFlagBits::eComputeShader,
-                    {},
-                    vk::MemoryBarrier {
-                        vk::AccessFlagBits::eShaderWrite, vk::AccessFlagBits::eShaderRead,
-                    },
-                    {}, {});
+                constexpr vk::MemoryBarrier2 memoryBarrier {
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead,
+                };
+                commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, memoryBarrier });
             }
 
+            // Each workgroup processes 16x16 texels of mipIndices.front() level, and their descendants in the later
+            // levels. Therefore, workgroups that cover the footprint of dirtyRect in mipIndices.front() level also
+            // cover the footprints in the later levels.
+            const std::uint32_t workgroupOffsetX = (static_cast<std::uint32_t>(dirtyRect.offset.x) >> mipIndices.front()) / 16U;
+            const std::uint32_t workgroupOffsetY = (static_cast<std::uint32_t>(dirtyRect.offset.y) >> mipIndices.front()) / 16U;
+            const std::uint32_t workgroupEndX = vku::divCeil(vku::divCeil(dirtyRect.offset.x + dirtyRect.extent.width, 1U << mipIndices.front()), 16U);
+            const std::uint32_t workgroupEndY = vku::divCeil(vku::divCeil(dirtyRect.offset.y + dirtyRect.extent.height, 1U << mipIndices.front()), 16U);
+
             commandBuffer.pushConstants<PushConstant>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, PushConstant {
                 mipIndices.front() - 1U,
                 static_cast<std::uint32_t>(mipIndices.size()),
+                { workgroupOffsetX, workgroupOffsetY },
             });
-            commandBuffer.dispatch(
-                (baseImageExtent.width >> mipIndices.front()) / 16U,
-                (baseImageExtent.height >> mipIndices.front()) / 16U,
-                1);
+            commandBuffer.dispatch(workgroupEndX - workgroupOffsetX, workgroupEndY - workgroupOffsetY, layerCount);
         }
     }
 
@@ -153,13 +195,31 @@ private:
 
     [[nodiscard]] auto createPipeline(
         const vk::raii::Device &device,
-        std::uint32_t subgroupSize
+        std::uint32_t subgroupSize,
+        Variant variant
     ) const -> vk::raii::Pipeline {
         const auto [_, stages] = vku::createStages(
             device,
             vku::Shader { vk::ShaderStageFlagBits::eCompute,
 #ifdef NDEBUG
                 vku::Shader::convert([=] {
+                    // Morton order kernels do not depend on the subgroup size.
+                    if (variant == Variant::Clustered) {
+                        return resources::shaders_subgroup_mipmap_clustered_comp();
+                    }
+                    if (variant == Variant::Quad) {
+                        return resources::shaders_subgroup_mipmap_quad_comp();
+                    }
+                    if (variant == Variant::ShuffleFp16) {
+                        switch (subgroupSize) {
+                            case 8U:   return resources::shaders_subgroup_mipmap_fp16_8_comp();
+                            case 16U:  return resources::shaders_subgroup_mipmap_fp16_16_comp();
+                            case 32U:  return resources::shaders_subgroup_mipmap_fp16_32_comp();
+                            case 64U:  return resources::shaders_subgroup_mipmap_fp16_64_comp();
+                            case 128U: return resources::shaders_subgroup_mipmap_fp16_128_comp();
+                            default:   throw std::runtime_error { "Subgroup size must be ≥ 8." };
+                        }
+                    }
                     switch (subgroupSize) {
                         case 8U:   return resources::shaders_subgroup_mipmap_8_comp();
                         case 16U:  return resources::shaders_subgroup_mipmap_16_comp();
@@ -170,7 +230,15 @@ private:
                     }
                 }()),
 #else
-                vku::Shader::readCode(std::format("shaders/subgroup_mipmap_{}.comp.spv", subgroupSize)),
+                vku::Shader::readCode([=] {
+                    switch (variant) {
+                        case Variant::Shuffle:     return std::format("shaders/subgroup_mipmap_{}.comp.spv", subgroupSize);
+                        case Variant::ShuffleFp16: return std::format("shaders/subgroup_mipmap_fp16_{}.comp.spv", subgroupSize);
+                        case Variant::Clustered:   return std::string { "shaders/subgroup_mipmap_clustered.comp.spv" };
+                        case Variant::Quad:        return std::string { "shaders/subgroup_mipmap_quad.comp.spv" };
+                    }
+                    std::unreachable();
+                }()),
 #endif
             });
         return { device, nullptr, vk::ComputePipelineCreateInfo {
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vku/DescriptorSetLayouts.hpp>
+#include <vku/DescriptorSets.hpp>
+#include <vku/pipelines.hpp>
+#include <vku/RefHolder.hpp>
+
+#ifdef NDEBUG
+#include <resources/shaders.hpp>
+#endif
+
+#define FWD(...) static_cast<decltype(__VA_ARGS__) &&>(__VA_ARGS__)
+
+/**
+ * Compute 3D image mipmaps using subgroup shuffle operation. More efficient than VolumeMipmapComputer.
+ *
+ * Each workgroup processes 8x8x8 texels of the base level, and reduces them to 3 mip levels. Its invocations are laid in
+ * Morton order, therefore every 8 consecutive subgroup invocations form a 2x2x2 brick, and 64 of them form a 4x4x4 brick.
+ *
+ * @code
+ * // Create pipeline and corresponding descriptor sets.
+ * SubgroupVolumeMipmapComputer subgroupVolumeMipmapComputer { device, mipImageCount, subgroupSize }; // mipImageCount = targetImage.mipLevels
+ * SubgroupVolumeMipmapComputer::DescriptorSets descriptorSets { device, descriptorPool, subgroupVolumeMipmapComputer.descriptorSetLayouts };
+ *
+ * // Update descriptorSets with image's mip views.
+ * device.updateDescriptorSets(
+ *     descriptorSets.getDescriptorWrites0(imageMipViews | ranges::views::deref).get(),
+ *     {});
+ *
+ * // Execute compute shader.
+ * // Image layout must be VK_IMAGE_LAYOUT_GENERAL.
+ * subgroupVolumeMipmapComputer.compute(commandBuffer, descriptorSets, baseImageExtent, targetImage.mipLevels); // baseImageExtent = targetImage.extent
+ * @endcode
+ */
+class SubgroupVolumeMipmapComputer {
+public:
+    struct DescriptorSetLayouts : vku::DescriptorSetLayouts<1> {
+        explicit DescriptorSetLayouts(
+            const vk::raii::Device &device,
+            std::uint32_t mipImageCount
+        ) : vku::DescriptorSetLayouts<1> { device, LayoutBindings {
+            vk::DescriptorSetLayoutCreateFlagBits::eUpdateAfterBindPool,
+            vk::DescriptorSetLayoutBinding { 0, vk::DescriptorType::eStorageImage, mipImageCount, vk::ShaderStageFlagBits::eCompute },
+            std::array { vku::toFlags(vk::DescriptorBindingFlagBits::eUpdateAfterBind) },
+        } } { }
+    };
+
+    struct DescriptorSets : vku::DescriptorSets<DescriptorSetLayouts> {
+        using vku::DescriptorSets<DescriptorSetLayouts>::DescriptorSets;
+
+        [[nodiscard]] auto getDescriptorWrites0(
+            auto &&mipImageViews
+        ) const noexcept {
+            return vku::RefHolder {
+                [this](std::span<const vk::DescriptorImageInfo> imageInfos) {
+                    return std::array {
+                        getDescriptorWrite<0, 0>().setImageInfo(imageInfos),
+                    };
+                },
+                FWD(mipImageViews)
+                    | std::views::transform([](vk::ImageView imageView) {
+                        return vk::DescriptorImageInfo { {}, imageView, vk::ImageLayout::eGeneral };
+                    })
+                    | std::ranges::to<std::vector>(),
+            };
+        }
+    };
+
+    struct PushConstant {
+        std::uint32_t baseLevel;
+        std::uint32_t remainingMipLevels;
+    };
+
+    DescriptorSetLayouts descriptorSetLayouts;
+    vk::raii::PipelineLayout pipelineLayout;
+    vk::raii::Pipeline pipeline;
+
+    explicit SubgroupVolumeMipmapComputer(
+        const vk::raii::Device &device,
+        std::uint32_t mipImageCount,
+        std::uint32_t subgroupSize
+    ) : descriptorSetLayouts { device, mipImageCount },
+        pipelineLayout { createPipelineLayout(device) },
+        pipeline { createPipeline(device, subgroupSize) } { }
+
+    auto compute(
+        vk::CommandBuffer commandBuffer,
+        const DescriptorSets &descriptorSets,
+        const vk::Extent3D &baseImageExtent,
+        std::uint32_t mipLevels
+    ) const -> void {
+        // Base image size must be greater than or equal to 8. Therefore, the first execution may process less than 3 mip levels.
+        // For example, if base extent is 256x256x256 (mipLevels=9),
+        // Step 0 (256 -> 64)
+        // Step 1 (64 -> 8)
+        // Step 2 (8 -> 1) (full processing required)
+        std::vector<std::vector<std::uint32_t>> indexChunks;
+        for (int endMipLevel = mipLevels; endMipLevel > 1; endMipLevel -= 3) {
+            indexChunks.emplace_back(
+                std::views::iota(
+                    static_cast<std::uint32_t>(std::max(1, endMipLevel - 3)),
+                    static_cast<std::uint32_t>(endMipLevel))
+                | std::ranges::to<std::vector>());
+        }
+        std::ranges::reverse(indexChunks);
+
+        commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+        commandBuffer.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, descriptorSets, {});
+        for (const auto &[idx, mipIndices] : indexChunks | ranges::views::enumerate) {
+            if (idx != 0) {
+                constexpr vk::MemoryBarrier2 memoryBarrier {
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageWrite,
+                    vk::PipelineStageFlagBits2::eComputeShader, vk::AccessFlagBits2::eShaderStorageRead,
+                };
+                commandBuffer.pipelineBarrier2(vk::DependencyInfo { {}, memoryBarrier });
+            }
+
+            commandBuffer.pushConstants<PushConstant>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, PushConstant {
+                mipIndices.front() - 1U,
+                static_cast<std::uint32_t>(mipIndices.size()),
+            });
+            commandBuffer.dispatch(
+                (baseImageExtent.width >> mipIndices.front()) / 4U,
+                (baseImageExtent.height >> mipIndices.front()) / 4U,
+                (baseImageExtent.depth >> mipIndices.front()) / 4U);
+        }
+    }
+
+private:
+    [[nodiscard]] auto createPipelineLayout(
+        const vk::raii::Device &device
+    ) const -> vk::raii::PipelineLayout {
+        constexpr vk::PushConstantRange pushConstantRange {
+            vk::ShaderStageFlagBits::eCompute,
+            0, sizeof(PushConstant),
+        };
+        return { device, vk::PipelineLayoutCreateInfo {
+            {},
+            descriptorSetLayouts,
+            pushConstantRange,
+        } };
+    }
+
+    [[nodiscard]] auto createPipeline(
+        const vk::raii::Device &device,
+        std::uint32_t subgroupSize
+    ) const -> vk::raii::Pipeline {
+        // If subgroup size is less than 64, the last level is reduced through the shared memory.
+        const auto [_, stages] = vku::createStages(
+            device,
+            vku::Shader { vk::ShaderStageFlagBits::eCompute,
+#ifdef NDEBUG
+                vku::Shader::convert([=] {
+                    switch (subgroupSize) {
+                        case 8U: case 16U: case 32U: return resources::shaders_subgroup_mipmap_3d_8_comp();
+                        case 64U: case 128U:         return resources::shaders_subgroup_mipmap_3d_64_comp();
+                        default:                     throw std::runtime_error { "Subgroup size must be ≥ 8." };
+                    }
+                }()),
+#else
+                vku::Shader::readCode(std::format("shaders/subgroup_mipmap_3d_{}.comp.spv", subgroupSize >= 64U ? 64U : 8U)),
+#endif
+            });
+        return { device, nullptr, vk::ComputePipelineCreateInfo {
+            {},
+            get<0>(stages),
+            *pipelineLayout,
+        } };
+    }
+};
\ No newline at end of file